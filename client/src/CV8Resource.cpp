@@ -26,7 +26,7 @@
 
 #include "workers/CWorker.h"
 
-#include "JSBindings.h"
+#include "V8CodeCache.h"
 
 extern void StaticRequire(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
@@ -40,6 +40,7 @@ extern void StaticRequire(const v8::FunctionCallbackInfo<v8::Value>& info)
     if (isWorker)
     {
         auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+        V8_CHECK(worker, "Worker was destroyed");
         handler = worker;
     }
     else
@@ -120,11 +121,7 @@ bool CV8ResourceImpl::Start()
     bool result = V8Helpers::TryCatch(
         [&]()
         {
-            v8::MaybeLocal<v8::Module> maybeModule;
-            v8::ScriptOrigin scriptOrigin(isolate, V8Helpers::JSValue("<bootstrapper>"), 0, 0, false, -1,
-                                          v8::Local<v8::Value>(), false, false, true, v8::Local<v8::PrimitiveArray>());
-            v8::ScriptCompiler::Source source{V8Helpers::JSValue(bootstrap_code), scriptOrigin};
-            maybeModule = v8::ScriptCompiler::CompileModule(isolate, &source);
+            v8::MaybeLocal<v8::Module> maybeModule = V8CodeCache::CompileModule(isolate, "<bootstrapper>", bootstrap_code);
 
             if (maybeModule.IsEmpty()) return false;
 
@@ -132,8 +129,8 @@ bool CV8ResourceImpl::Start()
 
             ctx->Global()->Set(ctx, V8Helpers::JSValue("__internal_get_exports"),
                                v8::Function::New(ctx, &StaticRequire).ToLocalChecked());
-            ctx->Global()->Set(ctx, V8Helpers::JSValue("__internal_bindings_code"),
-                               V8Helpers::JSValue(JSBindings::GetBindingsCode()));
+            ctx->Global()->Set(ctx, V8Helpers::JSValue("__internal_load_bindings"),
+                               v8::Function::New(ctx, &V8CodeCache::LoadBindings).ToLocalChecked());
             ctx->Global()->Set(ctx, V8Helpers::JSValue("__internal_main_path"), V8Helpers::JSValue(path));
             ctx->Global()->Set(ctx, V8Helpers::JSValue("__internal_start_file"),
                                v8::Function::New(ctx, &StartFile).ToLocalChecked());
@@ -141,6 +138,8 @@ bool CV8ResourceImpl::Start()
             bool result = InstantiateModule(curModule);
             if (!result) return false;
 
+            V8CodeCache::SaveUserModules(isolate, pendingCodeCaches);
+
             Log::Info << "[V8] Started script " << path << Log::Endl;
             return true;
         });
@@ -186,6 +185,9 @@ bool CV8ResourceImpl::Stop()
         }
 
         DispatchStopEvent();
+
+        // Modules that were imported dynamically after the start
+        V8CodeCache::SaveUserModules(isolate, pendingCodeCaches);
     }
 
     std::vector<alt::IBaseObject*> objects(ownedObjects.size());
@@ -219,7 +221,7 @@ bool CV8ResourceImpl::Stop()
     modules.clear();
     requiresMap.clear();
 
-    remoteHandlers.clear();
+    remoteHandlers.Clear();
 
     rpcHandlers.clear();
     remoteRPCHandlers.clear();
@@ -254,6 +256,16 @@ void CV8ResourceImpl::OnEvent(const alt::CEvent* e)
     }
 #endif
 
+    if (e->GetType() == alt::CEvent::Type::SERVER_SCRIPT_EVENT)
+    {
+        auto ev = static_cast<const alt::CServerScriptEvent*>(e);
+        if (ev->GetName() == V8Helpers::CLIENT_EVENT_BATCH)
+        {
+            HandleServerEventBatch(ev);
+            return;
+        }
+    }
+
     V8Helpers::EventHandler* handler = V8Helpers::EventHandler::Get(e);
     if (!handler) return;
 
@@ -262,17 +274,17 @@ void CV8ResourceImpl::OnEvent(const alt::CEvent* e)
         auto evType = e->GetType();
         if (evType == alt::CEvent::Type::CLIENT_SCRIPT_EVENT || evType == alt::CEvent::Type::SERVER_SCRIPT_EVENT)
         {
-            std::vector<V8Helpers::EventCallback*> callbacks;
+            V8Helpers::EventCallbackSpan callbacks;
             const char* eventName;
 
             if (evType == alt::CEvent::Type::CLIENT_SCRIPT_EVENT)
             {
-                callbacks = std::move(GetGenericHandlers(true));
+                callbacks = GetGenericHandlers(true);
                 eventName = static_cast<const alt::CClientScriptEvent*>(e)->GetName().c_str();
             }
             else if (evType == alt::CEvent::Type::SERVER_SCRIPT_EVENT)
             {
-                callbacks = std::move(GetGenericHandlers(false));
+                callbacks = GetGenericHandlers(false);
                 eventName = static_cast<const alt::CServerScriptEvent*>(e)->GetName().c_str();
             }
 
@@ -286,7 +298,7 @@ void CV8ResourceImpl::OnEvent(const alt::CEvent* e)
         }
     }
 
-    std::vector<V8Helpers::EventCallback*> callbacks = handler->GetCallbacks(this, e);
+    V8Helpers::EventCallbackSpan callbacks = handler->GetCallbacks(this, e);
     if (callbacks.size() > 0)
     {
         std::vector<v8::Local<v8::Value>> args = handler->GetArgs(this, e);
@@ -310,6 +322,37 @@ void CV8ResourceImpl::OnEvent(const alt::CEvent* e)
     }
 }
 
+void CV8ResourceImpl::HandleServerEventBatch(const alt::CServerScriptEvent* ev)
+{
+    const alt::MValueArgs& args = ev->GetArgs();
+    if (args.size() != 1 || args[0]->GetType() != alt::IMValue::Type::LIST) return;
+
+    alt::MValueListConst events = std::dynamic_pointer_cast<const alt::IMValueList>(args[0]);
+    for (size_t i = 0; i + 1 < events->GetSize(); i += 2)
+    {
+        v8::HandleScope handleScope(isolate);
+
+        auto name = std::dynamic_pointer_cast<const alt::IMValueString>(events->Get(i));
+        auto eventArgs = std::dynamic_pointer_cast<const alt::IMValueList>(events->Get(i + 1));
+        if (!name || !eventArgs) continue;
+
+        std::vector<v8::Local<v8::Value>> v8Args;
+        v8Args.reserve(eventArgs->GetSize() + 1);
+        for (size_t j = 0; j < eventArgs->GetSize(); j++) v8Args.push_back(V8Helpers::MValueToV8(eventArgs->Get(j)));
+
+        V8Helpers::EventCallbackSpan genericCallbacks = GetGenericHandlers(false);
+        if (genericCallbacks.size() != 0)
+        {
+            std::vector<v8::Local<v8::Value>> genericArgs = v8Args;
+            genericArgs.insert(genericArgs.begin(), V8Helpers::JSValue(name->Value()));
+            InvokeEventHandlers(ev, genericCallbacks, genericArgs);
+        }
+
+        V8Helpers::EventCallbackSpan callbacks = GetRemoteHandlers(name->Value());
+        if (callbacks.size() != 0) InvokeEventHandlers(ev, callbacks, v8Args);
+    }
+}
+
 void CV8ResourceImpl::HandleRPCAnswer(const alt::CScriptRPCAnswerEvent* ev)
 {
     auto answerId = ev->GetAnswerID();
@@ -349,7 +392,7 @@ void CV8ResourceImpl::HandleServerRPC(alt::CScriptRPCEvent* ev)
     std::vector<v8::Local<v8::Value>> args;
     V8Helpers::MValueArgsToV8(ev->GetArgs(), args);
 
-    auto result = V8Helpers::CallFunctionWithTimeout(handler->second.Get(isolate), context, args);
+    auto result = V8Helpers::CallFunctionWithTimeout(handler->second.Get(isolate), context, args, "RPC " + ev->GetName());
 
     v8::Local<v8::Value> returnValue;
     if (!result.IsEmpty())
@@ -468,7 +511,9 @@ void CV8ResourceImpl::OnTick()
     v8::HandleScope handleScope(isolate);
     v8::Context::Scope scope(GetContext());
 
+    int64_t microtasksStart = V8ResourceMetrics::Now();
     microtaskQueue->PerformCheckpoint(isolate);
+    metrics.AddMicrotasks(V8ResourceMetrics::Now() - microtasksStart);
 
     int64_t time = GetTime();
 
@@ -520,9 +565,13 @@ void CV8ResourceImpl::OnTick()
         }
     }
 
-    for (auto worker : workers)
+    // Handlers can destroy workers, so a copy is iterated and workers that were removed meanwhile are skipped
+    std::vector<CWorker*> currentWorkers(workers.begin(), workers.end());
+    for (auto worker : currentWorkers)
     {
+        if (workers.count(worker) == 0) continue;
         worker->GetMainEventHandler().Process();
+        if (worker->IsDestroyPending()) worker->Destroy();
     }
 
     promiseRejections.ProcessQueue(this);
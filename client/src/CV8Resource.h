@@ -2,6 +2,7 @@
 
 #include "cpp-sdk/IResource.h"
 #include "cpp-sdk/objects/IEntity.h"
+#include "cpp-sdk/events/CServerScriptEvent.h"
 
 #include "V8ResourceImpl.h"
 #include "IImportHandler.h"
@@ -59,6 +60,8 @@ public:
 
     void HandleRPCAnswer(const alt::CScriptRPCAnswerEvent* ev);
     void HandleServerRPC(alt::CScriptRPCEvent* ev);
+    // Dispatches the events of a batch sent by the server
+    void HandleServerEventBatch(const alt::CServerScriptEvent* ev);
     std::vector<V8Helpers::EventCallback*> GetWebViewHandlers(alt::IWebView* view, const std::string& name);
 
     void SubscribeWebSocketClient(alt::IWebSocketClient* webSocket, const std::string& evName, v8::Local<v8::Function> cb, V8Helpers::SourceLocation&& location)
@@ -5,6 +5,10 @@
 #include "V8Module.h"
 #include "events/Events.h"
 #include "CProfiler.h"
+#include "V8ResourceMetrics.h"
+#include "V8Watchdog.h"
+#include "V8CodeCache.h"
+#include "workers/CWorkerIsolatePool.h"
 
 CV8ScriptRuntime::CV8ScriptRuntime()
 {
@@ -19,6 +23,7 @@ CV8ScriptRuntime::CV8ScriptRuntime()
     create_params.allow_atomics_wait = false;
 
     isolate = v8::Isolate::New(create_params);
+    V8ResourceMetrics::RegisterGCCallbacks(isolate);
     isolate->SetFatalErrorHandler([](const char* location, const char* message) { Log::Error << "[V8] " << location << ": " << message << Log::Endl; });
 
     isolate->SetOOMErrorHandler(
@@ -217,6 +222,7 @@ CV8ScriptRuntime::CV8ScriptRuntime()
 
     RegisterEvents();
 
+    V8CodeCache::SetUserModulesDir(std::filesystem::path(alt::ICore::Instance().GetClientPath()) / "cache" / "js-module");
     ProcessConfigOptions();
 
     IRuntimeEventHandler::Start();
@@ -229,16 +235,42 @@ void CV8ScriptRuntime::ProcessConfigOptions()
 
     Config::Value::ValuePtr profiler = moduleConfig["profiler"];
     CProfiler::Instance().SetIsEnabled(profiler->AsBool(false));
+
+    Config::Value::ValuePtr logLevel = moduleConfig["logLevel"];
+    if(!logLevel->IsNone() && !Log::SetLevel(logLevel->AsString())) Log::Warning << "Invalid log level: " << logLevel->AsString() << Log::Endl;
+
+    Config::Value::ValuePtr executionTimeout = moduleConfig["executionTimeout"];
+    if(!executionTimeout->IsNone()) V8Watchdog::Instance().SetDefaultTimeout((uint32_t)executionTimeout->AsNumber(0));
+
+    Config::Value::ValuePtr workerExecutionTimeout = moduleConfig["workerExecutionTimeout"];
+    if(!workerExecutionTimeout->IsNone()) V8Watchdog::Instance().SetWorkerTimeout((uint32_t)workerExecutionTimeout->AsNumber(0));
+
+    Config::Value::ValuePtr zeroCopyByteArrays = moduleConfig["zeroCopyByteArrays"];
+    V8Helpers::SetZeroCopyByteArrays(zeroCopyByteArrays->AsBool(false));
+
+    Config::Value::ValuePtr codeCache = moduleConfig["codeCache"];
+    if(!codeCache->AsBool(true)) V8CodeCache::SetUserModulesDir({});
+
+    Config::Value::ValuePtr maxWorkersValue = moduleConfig["maxWorkers"];
+    if(!maxWorkersValue->IsNone()) maxWorkers = (uint32_t)maxWorkersValue->AsNumber(maxWorkers);
+
+    Config::Value::ValuePtr workerPoolSize = moduleConfig["workerPoolSize"];
+    if(!workerPoolSize->IsNone()) CWorkerIsolatePool::Instance().SetSize((size_t)workerPoolSize->AsNumber(0));
 }
 
 void CV8ScriptRuntime::OnDispose()
 {
+    V8Watchdog::Instance().Shutdown();
+    CWorkerIsolatePool::Instance().Shutdown();
+
     while(isolate->IsInUse()) isolate->Exit();
     isolate->Dispose();
     v8::V8::Dispose();
     v8::V8::ShutdownPlatform();
     delete create_params.array_buffer_allocator;
 
+    Log::Shutdown();
+
     if(CProfiler::Instance().IsEnabled()) CProfiler::Instance().Dump(alt::ICore::Instance().GetClientPath());
 
     CV8ScriptRuntime::SetInstance(nullptr);
@@ -10,6 +10,7 @@
 #include "cpp-sdk/objects/IVehicle.h"
 
 #include "CV8Resource.h"
+#include "CSpatialIndex.h"
 #include "IRuntimeEventHandler.h"
 
 class CV8ScriptRuntime : public alt::IScriptRuntime, public IRuntimeEventHandler
@@ -32,6 +33,7 @@ class CV8ScriptRuntime : public alt::IScriptRuntime, public IRuntimeEventHandler
     std::unordered_map<uint16_t, alt::IPed*> streamedInPeds;
 
     uint32_t activeWorkers = 0;
+    uint32_t maxWorkers = 10;
 
     static CV8ScriptRuntime*& _instance()
     {
@@ -94,6 +96,11 @@ public:
     {
         activeWorkers--;
     }
+    // Limit of workers that run at the same time, paused workers don't count
+    uint32_t GetMaxWorkers() const
+    {
+        return maxWorkers;
+    }
 
     v8::Platform* GetPlatform()
     {
@@ -111,6 +118,8 @@ public:
     {
         auto res = static_cast<CV8ResourceImpl*>(impl);
         resources.erase(res);
+        // Queued log lines still point to the resource
+        Log::Flush();
         delete res;
     }
 
@@ -121,6 +130,9 @@ public:
         v8::HandleScope handle_scope(isolate);
 
         v8::platform::PumpMessageLoop(platform.get(), isolate);
+
+        // Entities may have moved since the last tick
+        CSpatialIndex::Instance().Invalidate();
     }
 
     std::unordered_set<CV8ResourceImpl*> GetResources()
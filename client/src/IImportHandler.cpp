@@ -16,8 +16,23 @@ static inline bool IsSystemModule(v8::Isolate* isolate, const std::string& name)
     return V8Module::Exists(isolate, name);
 }
 
+// Exports the native functions themselves, so calls from a module don't go through a forwarding function.
+// Importing creates every native from the templates cached per isolate, and the source is compiled through the code cache.
+// The default export is the natives object, like for the other system modules.
+static inline v8::MaybeLocal<v8::Module> WrapNativesModule(v8::Isolate* isolate, const std::deque<std::string>& _exportKeys)
+{
+    std::stringstream src;
+    src << "const _exports = __internal_get_exports('natives');\n";
+    for(auto& key : _exportKeys) src << "export const " << key << " = _exports." << key << ";\n";
+    src << "export default _exports;";
+
+    return V8CodeCache::CompileModule(isolate, "natives", src.str());
+}
+
 static inline v8::MaybeLocal<v8::Module> WrapModule(v8::Isolate* isolate, const std::deque<std::string>& _exportKeys, const std::string& name, bool exportAsDefault = false)
 {
+    if(name == "natives") return WrapNativesModule(isolate, _exportKeys);
+
     bool hasDefault = false;
     std::stringstream src;
 
@@ -185,7 +200,7 @@ v8::MaybeLocal<v8::Module> IImportHandler::ResolveFile(const std::string& name,
           if(!isBytecode)
           {
               std::string src{ (char*)byteBuffer, fileSize };
-              maybeModule = CompileESM(isolate, fullName, src);
+              maybeModule = V8CodeCache::CompileUserModule(isolate, resource->GetName(), fullName, src, pendingCodeCaches);
           }
           else
           {
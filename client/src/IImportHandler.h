@@ -2,6 +2,7 @@
 
 #include "v8.h"
 #include "V8Helpers.h"
+#include "V8CodeCache.h"
 #include <queue>
 
 class IImportHandler
@@ -15,6 +16,8 @@ protected:
 
     std::unordered_map<std::string, V8Helpers::CPersistent<v8::Value>> requiresMap;
     std::unordered_map<std::string, ModuleData> modules;
+    // Modules compiled without code cache, the cache is written after the resource started
+    std::vector<V8CodeCache::PendingModule> pendingCodeCaches;
 
     bool IsValidModule(const std::string& name);
     bool IsBytecodeModule(uint8_t* buffer, size_t size);
@@ -1,6 +1,7 @@
 #include "../CV8Resource.h"
 #include "V8Helpers.h"
 #include "helpers/BindHelpers.h"
+#include "CSpatialIndex.h"
 #include "cpp-sdk/script-objects/ILocalObject.h"
 
 static void ToString(const v8::FunctionCallbackInfo<v8::Value>& info)
@@ -55,6 +56,7 @@ static void PosSetter(v8::Local<v8::String>, v8::Local<v8::Value> value, const v
     V8_GET_THIS_BASE_OBJECT(object, alt::ILocalObject);
     V8_TO_VECTOR3(value, val);
     object->SetPosition(val);
+    CSpatialIndex::Instance().Update(object);
 }
 
 static void RotGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
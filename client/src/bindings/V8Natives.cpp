@@ -9,7 +9,17 @@ static bool strictChecks = false;
 static uint64_t pointers[32];
 static uint32_t pointersCount = 0;
 
-static uint32_t returnsCount = 1;
+// Everything about a native that is needed to call it, computed once instead of on every call
+struct NativeCallPlan
+{
+    alt::INative* native;
+    std::vector<alt::INative::Type> args;
+    alt::INative::Type retnType;
+    // Types of the pointer args, their values are returned in this order after the return value
+    std::vector<alt::INative::Type> pointerArgs;
+    int neededArgs = 0;
+    std::unordered_map<v8::Isolate*, v8::Eternal<v8::FunctionTemplate>> templates;
+};
 
 static char* SaveString(const char* str)
 {
@@ -128,7 +138,6 @@ static bool PushArg(
     {
         case alt::INative::Type::ARG_BOOL: scrCtx->Push((int32_t)val->ToBoolean(isolate)->Value()); break;
         case alt::INative::Type::ARG_BOOL_PTR:
-            ++returnsCount;
             scrCtx->Push(SavePointer((int32_t)val->ToBoolean(isolate)->Value()));
             break;
         case alt::INative::Type::ARG_INT32:
@@ -193,7 +202,6 @@ static bool PushArg(
             break;
         }
         case alt::INative::Type::ARG_INT32_PTR:
-            ++returnsCount;
             scrCtx->Push(SavePointer((int32_t)val->ToInteger(v8Ctx).ToLocalChecked()->Value()));
             break;
         case alt::INative::Type::ARG_UINT32:
@@ -238,7 +246,6 @@ static bool PushArg(
             break;
         }
         case alt::INative::Type::ARG_UINT32_PTR:
-            ++returnsCount;
             scrCtx->Push(SavePointer((uint32_t)val->ToInteger(v8Ctx).ToLocalChecked()->Value()));
             break;
         case alt::INative::Type::ARG_FLOAT:
@@ -265,11 +272,9 @@ static bool PushArg(
             break;
         }
         case alt::INative::Type::ARG_FLOAT_PTR:
-            ++returnsCount;
             scrCtx->Push(SavePointer((float)val->ToNumber(v8Ctx).ToLocalChecked()->Value()));
             break;
         case alt::INative::Type::ARG_VECTOR3_PTR:
-            ++returnsCount;
             scrCtx->Push(SavePointer(alt::INative::Vector3{}));  // TODO: Add initializer
             break;
         case alt::INative::Type::ARG_STRING:
@@ -310,16 +315,16 @@ static bool PushArg(
     return true;
 }
 
-static void PushPointerReturn(alt::INative::Type argType, v8::Local<v8::Array> retns, v8::Isolate* isolate, v8::Local<v8::Context> ctx)
+static void PushPointerReturn(alt::INative::Type argType, v8::Local<v8::Array> retns, uint32_t idx, v8::Isolate* isolate, v8::Local<v8::Context> ctx)
 {
     using ArgType = alt::INative::Type;
 
     switch(argType)
     {
-        case alt::INative::Type::ARG_BOOL_PTR: retns->Set(ctx, returnsCount++, V8Helpers::JSValue((bool)*reinterpret_cast<int32_t*>(&pointers[pointersCount++]))); break;
-        case alt::INative::Type::ARG_INT32_PTR: retns->Set(ctx, returnsCount++, V8Helpers::JSValue(*reinterpret_cast<int32_t*>(&pointers[pointersCount++]))); break;
-        case alt::INative::Type::ARG_UINT32_PTR: retns->Set(ctx, returnsCount++, V8Helpers::JSValue(*reinterpret_cast<uint32_t*>(&pointers[pointersCount++]))); break;
-        case alt::INative::Type::ARG_FLOAT_PTR: retns->Set(ctx, returnsCount++, V8Helpers::JSValue(*reinterpret_cast<float*>(&pointers[pointersCount++]))); break;
+        case alt::INative::Type::ARG_BOOL_PTR: retns->Set(ctx, idx, V8Helpers::JSValue((bool)*reinterpret_cast<int32_t*>(&pointers[pointersCount++]))); break;
+        case alt::INative::Type::ARG_INT32_PTR: retns->Set(ctx, idx, V8Helpers::JSValue(*reinterpret_cast<int32_t*>(&pointers[pointersCount++]))); break;
+        case alt::INative::Type::ARG_UINT32_PTR: retns->Set(ctx, idx, V8Helpers::JSValue(*reinterpret_cast<uint32_t*>(&pointers[pointersCount++]))); break;
+        case alt::INative::Type::ARG_FLOAT_PTR: retns->Set(ctx, idx, V8Helpers::JSValue(*reinterpret_cast<float*>(&pointers[pointersCount++]))); break;
         case alt::INative::Type::ARG_VECTOR3_PTR:
         {
             alt::INative::Vector3* val = reinterpret_cast<alt::INative::Vector3*>(&pointers[pointersCount]);
@@ -329,7 +334,7 @@ static void PushPointerReturn(alt::INative::Type argType, v8::Local<v8::Array> r
             V8ResourceImpl* resource = V8ResourceImpl::Get(v8Ctx);
             auto vector = resource->CreateVector3({ val->x, val->y, val->z }).As<v8::Object>();
 
-            retns->Set(ctx, returnsCount++, vector);
+            retns->Set(ctx, idx, vector);
             break;
         }
     }
@@ -362,18 +367,33 @@ static v8::Local<v8::Value> GetReturn(std::shared_ptr<alt::INative::Context> scr
     }
 }
 
-static inline int GetNativeNeededArgCount(alt::INative* native)
+static inline bool IsPointerArg(alt::INative::Type arg)
 {
-    int count = 0;
-    auto args = native->GetArgTypes();
-    for(auto arg : args)
+    return arg == alt::INative::Type::ARG_BOOL_PTR || arg == alt::INative::Type::ARG_INT32_PTR || arg == alt::INative::Type::ARG_UINT32_PTR || arg == alt::INative::Type::ARG_FLOAT_PTR ||
+           arg == alt::INative::Type::ARG_VECTOR3_PTR;
+}
+
+static std::vector<NativeCallPlan>& GetCallPlans()
+{
+    static std::vector<NativeCallPlan> plans = []()
     {
-        if(arg == alt::INative::Type::ARG_BOOL_PTR || arg == alt::INative::Type::ARG_INT32_PTR || arg == alt::INative::Type::ARG_UINT32_PTR || arg == alt::INative::Type::ARG_FLOAT_PTR ||
-           arg == alt::INative::Type::ARG_VOID || arg == alt::INative::Type::ARG_VECTOR3_PTR)
-            continue;
-        count++;
-    }
-    return count;
+        std::vector<NativeCallPlan> result;
+        for(auto native : alt::ICore::Instance().GetAllNatives())
+        {
+            NativeCallPlan& plan = result.emplace_back();
+            plan.native = native;
+            plan.args = native->GetArgTypes();
+            plan.retnType = native->GetRetnType();
+            for(auto arg : plan.args)
+            {
+                if(IsPointerArg(arg)) plan.pointerArgs.push_back(arg);
+                else if(arg != alt::INative::Type::ARG_VOID)
+                    plan.neededArgs++;
+            }
+        }
+        return result;
+    }();
+    return plans;
 }
 
 static void InvokeNative(const v8::FunctionCallbackInfo<v8::Value>& info)
@@ -383,7 +403,8 @@ static void InvokeNative(const v8::FunctionCallbackInfo<v8::Value>& info)
     v8::Isolate* isolate = info.GetIsolate();
     v8::Local<v8::Context> v8Ctx = isolate->GetCurrentContext();
 
-    auto native = static_cast<alt::INative*>(info.Data().As<v8::External>()->Value());
+    auto plan = static_cast<NativeCallPlan*>(info.Data().As<v8::External>()->Value());
+    alt::INative* native = plan->native;
 
     if(!native->IsValid())
     {
@@ -392,23 +413,20 @@ static void InvokeNative(const v8::FunctionCallbackInfo<v8::Value>& info)
     }
 
     auto resource = V8ResourceImpl::Get(v8Ctx);
-    auto args = native->GetArgTypes();
-    uint32_t argsSize = args.size();
+    uint32_t argsSize = plan->args.size();
 
-    auto neededArgs = GetNativeNeededArgCount(native);
-    if(neededArgs > info.Length())
+    if(plan->neededArgs > info.Length())
     {
-        ShowNativeArgMismatchErrorMsg(resource, native, neededArgs, info.Length());
+        ShowNativeArgMismatchErrorMsg(resource, native, plan->neededArgs, info.Length());
         return;
     }
 
     ctx->Reset();
     pointersCount = 0;
-    returnsCount = 1;
 
     for(uint32_t i = 0; i < argsSize; ++i)
     {
-        if(!PushArg(ctx, native, args[i], isolate, resource, info[i], i)) return;
+        if(!PushArg(ctx, native, plan->args[i], isolate, resource, info[i], i)) return;
     }
 
     if(!native->Invoke(ctx))
@@ -417,24 +435,46 @@ static void InvokeNative(const v8::FunctionCallbackInfo<v8::Value>& info)
         return;
     }
 
-    if(returnsCount == 1)
+    if(plan->pointerArgs.empty())
     {
-        info.GetReturnValue().Set(GetReturn(ctx, native, native->GetRetnType(), isolate));
+        info.GetReturnValue().Set(GetReturn(ctx, native, plan->retnType, isolate));
     }
     else
     {
-        v8::Local<v8::Array> retns = v8::Array::New(isolate, returnsCount);
-        retns->Set(v8Ctx, 0, GetReturn(ctx, native, native->GetRetnType(), isolate));
+        v8::Local<v8::Array> retns = v8::Array::New(isolate, plan->pointerArgs.size() + 1);
+        retns->Set(v8Ctx, 0, GetReturn(ctx, native, plan->retnType, isolate));
 
         pointersCount = 0;
-        returnsCount = 1;
 
-        for(uint32_t i = 0; i < argsSize; ++i) PushPointerReturn(args[i], retns, isolate, v8Ctx);
+        uint32_t returnIdx = 1;
+        for(auto argType : plan->pointerArgs) PushPointerReturn(argType, retns, returnIdx++, isolate, v8Ctx);
 
         info.GetReturnValue().Set(retns);
     }
 }
 
+// The native functions are only created when they are accessed for the first time
+static void NativeGetter(v8::Local<v8::Name> property, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+    v8::Isolate* isolate = info.GetIsolate();
+    v8::Local<v8::Context> ctx = isolate->GetCurrentContext();
+    auto plan = static_cast<NativeCallPlan*>(info.Data().As<v8::External>()->Value());
+
+    // The template is shared by all resources, so the function code only exists once per isolate
+    auto it = plan->templates.find(isolate);
+    if(it == plan->templates.end())
+    {
+        v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, InvokeNative, info.Data());
+        tpl->SetClassName(property.As<v8::String>());
+        it = plan->templates.insert({ isolate, v8::Eternal<v8::FunctionTemplate>(isolate, tpl) }).first;
+    }
+
+    v8::Local<v8::Function> fn;
+    if(!it->second.Get(isolate)->GetFunction(ctx).ToLocal(&fn)) return;
+    fn->SetName(property.As<v8::String>());
+    info.GetReturnValue().Set(fn);
+}
+
 static void ToggleStrictChecks(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
     V8_GET_ISOLATE();
@@ -448,9 +488,10 @@ static void RegisterNatives(v8::Local<v8::Context> ctx, v8::Local<v8::Object> ex
 
     V8Helpers::SetFunction(isolate, ctx, exports, "toggleStrictChecks", ToggleStrictChecks);
 
-    for(auto native : alt::ICore::Instance().GetAllNatives())
+    for(auto& plan : GetCallPlans())
     {
-        V8Helpers::SetFunction(isolate, ctx, exports, native->GetName().c_str(), InvokeNative, native);
+        v8::Local<v8::String> name = v8::String::NewFromUtf8(isolate, plan.native->GetName().c_str(), v8::NewStringType::kInternalized).ToLocalChecked();
+        exports->SetLazyDataProperty(ctx, name, NativeGetter, v8::External::New(isolate, &plan));
     }
 }
 
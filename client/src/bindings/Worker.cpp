@@ -8,8 +8,6 @@
 
 #include "../workers/CWorker.h"
 
-static constexpr uint32_t MAX_WORKERS = 10;
-
 static void Constructor(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
     // Deprecation added: 11/11/2022 (version 13)
@@ -68,7 +66,7 @@ static void Start(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_CHECK(worker, "Worker is invalid");
 
     V8_CHECK(!worker->IsReady(), "Worker is already started");
-    V8_CHECK(CV8ScriptRuntime::Instance().GetActiveWorkerCount() < MAX_WORKERS, "Maximum amount of running workers reached");
+    V8_CHECK(CV8ScriptRuntime::Instance().GetActiveWorkerCount() < CV8ScriptRuntime::Instance().GetMaxWorkers(), "Maximum amount of running workers reached");
     worker->Start();
 }
 
@@ -93,20 +91,27 @@ static void Emit(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_ARG_TO_STRING(1, eventName);
 
     std::vector<V8Helpers::Serialization::Value> args;
-    args.reserve(info.Length() - 1);
-    for(int i = 1; i < info.Length(); i++)
-    {
-        auto arg = V8Helpers::Serialization::Serialize(ctx, info[i]);
-        if(!arg.Valid())
-        {
-            V8Helpers::Throw(isolate, "Invalid argument");
-            return;
-        }
-        args.push_back(arg);
-    }
+    CEventHandler::Transfers transfers;
+    if(!CEventHandler::SerializeArgs(info, 1, v8::Local<v8::Array>(), args, transfers)) return;
     worker->GetWorkerEventHandler().Emit(eventName, args);
 }
 
+static void EmitTransfer(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN_MIN(2);
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, worker, CWorker);
+    V8_CHECK(worker, "Worker is invalid");
+
+    V8_ARG_TO_STRING(1, eventName);
+    V8_ARG_TO_ARRAY(2, transferList);
+
+    std::vector<V8Helpers::Serialization::Value> args;
+    CEventHandler::Transfers transfers;
+    if(!CEventHandler::SerializeArgs(info, 2, transferList, args, transfers)) return;
+    worker->GetWorkerEventHandler().Emit(eventName, args, std::move(transfers));
+}
+
 static void On(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
     V8_GET_ISOLATE_CONTEXT();
@@ -173,7 +178,7 @@ static void Resume(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_CHECK(worker, "Worker is invalid");
 
     V8_CHECK(worker->IsPaused(), "The worker is not paused");
-    V8_CHECK(CV8ScriptRuntime::Instance().GetActiveWorkerCount() < MAX_WORKERS, "Maximum amount of running workers reached");
+    V8_CHECK(CV8ScriptRuntime::Instance().GetActiveWorkerCount() < CV8ScriptRuntime::Instance().GetMaxWorkers(), "Maximum amount of running workers reached");
     worker->Resume();
     CV8ScriptRuntime::Instance().AddActiveWorker();
 }
@@ -201,12 +206,35 @@ static void RemoveSharedArrayBuffer(const v8::FunctionCallbackInfo<v8::Value>& i
     V8_CHECK(result, "Invalid shared array buffer index");
 }
 
+static void CreateMessageChannel(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+
+    V8_RETURN_UINT(CMessageChannel::Create());
+}
+
+static void RemoveMessageChannel(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN(1);
+
+    V8_ARG_TO_UINT(1, id);
+
+    V8_CHECK(CMessageChannel::Remove(id), "Invalid message channel id");
+}
+
 static void ActiveWorkersGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
 {
     V8_GET_ISOLATE();
     V8_RETURN(CV8ScriptRuntime::Instance().GetActiveWorkerCount());
 }
 
+static void MaxWorkersGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE();
+    V8_RETURN(CV8ScriptRuntime::Instance().GetMaxWorkers());
+}
+
 extern V8Class v8Worker("Worker",
                         &Constructor,
                         [](v8::Local<v8::FunctionTemplate> tpl)
@@ -214,11 +242,13 @@ extern V8Class v8Worker("Worker",
                             v8::Isolate* isolate = v8::Isolate::GetCurrent();
                             tpl->InstanceTemplate()->SetInternalFieldCount(1);
 
-                            tpl->Set(V8Helpers::JSValue("maxWorkers"), V8Helpers::JSValue(MAX_WORKERS), v8::PropertyAttribute::ReadOnly);
+                            V8Helpers::SetStaticAccessor(isolate, tpl, "maxWorkers", &MaxWorkersGetter);
                             V8Helpers::SetStaticAccessor(isolate, tpl, "activeWorkers", &ActiveWorkersGetter);
 
                             V8Helpers::SetStaticMethod(isolate, tpl, "addSharedArrayBuffer", AddSharedArrayBuffer);
                             V8Helpers::SetStaticMethod(isolate, tpl, "removeSharedArrayBuffer", RemoveSharedArrayBuffer);
+                            V8Helpers::SetStaticMethod(isolate, tpl, "createMessageChannel", CreateMessageChannel);
+                            V8Helpers::SetStaticMethod(isolate, tpl, "removeMessageChannel", RemoveMessageChannel);
 
                             V8Helpers::SetMethod(isolate, tpl, "toString", ToString);
                             V8Helpers::SetAccessor(isolate, tpl, "valid", ValidGetter);
@@ -228,6 +258,7 @@ extern V8Class v8Worker("Worker",
                             V8Helpers::SetMethod(isolate, tpl, "destroy", Destroy);
 
                             V8Helpers::SetMethod(isolate, tpl, "emit", Emit);
+                            V8Helpers::SetMethod(isolate, tpl, "emitTransfer", EmitTransfer);
                             V8Helpers::SetMethod(isolate, tpl, "on", On);
                             V8Helpers::SetMethod(isolate, tpl, "off", Off);
                             V8Helpers::SetMethod(isolate, tpl, "once", Once);
@@ -1,10 +1,11 @@
 // clang-format off
 import * as alt from "alt";
-import * as native from "natives"; 
+// Not imported, that would create every native, the exports object creates them when they are accessed
+const native = __internal_get_exports("natives");
 
 // Load the global bindings code
 const bindingsGlobal = {};
-new Function("alt", "native", "__global", __internal_bindings_code)(alt, native, bindingsGlobal);
+__internal_load_bindings(alt, native, bindingsGlobal);
 __setLogFunction(bindingsGlobal.genericLog);
 
 const extraBootstrapFile = __getExtraBootstrapFile();
@@ -113,14 +113,17 @@ V8_EVENT_HANDLER keyboardEvent(
   EventType::KEYBOARD_EVENT,
   [](V8ResourceImpl* resource, const CEvent* e)
   {
+      static uint32_t keyupId = V8Helpers::EventNames::Intern("keyup");
+      static uint32_t keydownId = V8Helpers::EventNames::Intern("keydown");
+
       auto ev = static_cast<const alt::CKeyboardEvent*>(e);
-      if(ev->GetKeyState() == alt::CKeyboardEvent::KeyState::UP) return resource->GetLocalHandlers("keyup");
+      if(ev->GetKeyState() == alt::CKeyboardEvent::KeyState::UP) return resource->GetLocalHandlers(keyupId);
       else if(ev->GetKeyState() == alt::CKeyboardEvent::KeyState::DOWN)
-          return resource->GetLocalHandlers("keydown");
+          return resource->GetLocalHandlers(keydownId);
       else
       {
           Log::Error << "Unhandled keystate in keyboard event handler: " << (int)ev->GetKeyState() << Log::Endl;
-          return std::vector<V8Helpers::EventCallback*>();
+          return V8Helpers::EventCallbackSpan();
       }
   },
   [](V8ResourceImpl* resource, const CEvent* e, std::vector<v8::Local<v8::Value>>& args)
@@ -21,9 +21,11 @@ V8_EVENT_HANDLER gameEntityCreate(
   EventType::GAME_ENTITY_CREATE,
   [](V8ResourceImpl* resource, const alt::CEvent* e)
   {
+      static uint32_t eventId = V8Helpers::EventNames::Intern("gameEntityCreate");
+
       CV8ScriptRuntime::Instance().OnEntityStreamIn(static_cast<const alt::CGameEntityCreateEvent*>(e)->GetTarget());
 
-      return resource->GetLocalHandlers("gameEntityCreate");
+      return resource->GetLocalHandlers(eventId);
   },
   [](V8ResourceImpl* resource, const alt::CEvent* e, std::vector<v8::Local<v8::Value>>& args)
   {
@@ -37,9 +39,11 @@ V8_EVENT_HANDLER gameEntityDestroy(
   EventType::GAME_ENTITY_DESTROY,
   [](V8ResourceImpl* resource, const alt::CEvent* e)
   {
+      static uint32_t eventId = V8Helpers::EventNames::Intern("gameEntityDestroy");
+
       CV8ScriptRuntime::Instance().OnEntityStreamOut(static_cast<const alt::CGameEntityDestroyEvent*>(e)->GetTarget());
 
-      return resource->GetLocalHandlers("gameEntityDestroy");
+      return resource->GetLocalHandlers(eventId);
   },
   [](V8ResourceImpl* resource, const alt::CEvent* e, std::vector<v8::Local<v8::Value>>& args)
   {
@@ -6,6 +6,7 @@
 #endif
 #include "CV8ScriptRuntime.h"
 #include "Log.h"
+#include "V8CodeCache.h"
 
 #ifdef ALTV_JS_SHARED
     #define ALTV_JS_EXPORT extern "C" __declspec(dllexport)
@@ -87,6 +88,21 @@ static void ClientJSCommand(const std::vector<std::string>& args)
         Log::Colored << "~y~Options:" << Log::Endl;
         Log::Colored << "  ~ly~--help    ~w~- this message." << Log::Endl;
         Log::Colored << "  ~ly~--version ~w~- version info." << Log::Endl;
+        Log::Colored << "  ~ly~--code-cache ~w~- compile times of the embedded code and user modules, with and without code cache." << Log::Endl;
+        Log::Colored << "  ~ly~--bench [iterations] ~w~- benchmarks the hot paths of the module in every started resource." << Log::Endl;
+        Log::Colored << "  ~ly~--log-level <debug|info|warning|error> ~w~- hides the log lines below the level." << Log::Endl;
+    }
+    else if(args[0] == "--code-cache")
+    {
+        V8CodeCache::PrintStats();
+    }
+    else if(args[0] == "--log-level")
+    {
+        if(args.size() < 2 || !Log::SetLevel(args[1])) Log::Error << "Invalid log level, expected one of: debug, info, warning, error" << Log::Endl;
+    }
+    else if(args[0] == "--bench")
+    {
+        V8ResourceImpl::RunBenchmarksCommand(args);
     }
 }
 
@@ -1,10 +1,15 @@
 #include "CEventHandler.h"
+
+#include <algorithm>
+
 #include "V8ResourceImpl.h"
 
-void CEventHandler::Emit(const std::string& eventName, const std::vector<V8Helpers::Serialization::Value>& args)
+void CEventHandler::Emit(const std::string& eventName, const std::vector<V8Helpers::Serialization::Value>& args, Transfers&& transfers)
 {
     std::scoped_lock lock(queueLock);
-    queue.push(std::make_pair(eventName, std::move(args)));
+    queue.push(QueueItem{ eventName, std::move(args), std::move(transfers) });
+    // Called while locked, so the receiver can't be destroyed after clearing the callback
+    if(emitCallback) emitCallback();
 }
 
 void CEventHandler::Subscribe(const std::string& eventName, v8::Local<v8::Function> callback, bool once)
@@ -39,7 +44,7 @@ void CEventHandler::CleanupHandlers()
     }
 }
 
-void CEventHandler::Process()
+void CEventHandler::Process(const std::function<void()>& afterEvent)
 {
     if(queue.empty()) return;
     CleanupHandlers();
@@ -47,33 +52,39 @@ void CEventHandler::Process()
     v8::Isolate* isolate = v8::Isolate::GetCurrent();
     v8::Local<v8::Context> context = isolate->GetEnteredOrMicrotaskContext();
 
-    while(!queue.empty())
+    processing = true;
+    while(!queue.empty() && !resetPending)
     {
         // Get the event at the front of the queue
         queueLock.lock();
         QueueItem& event = queue.front();
 
+        // The transferred backing stores are now owned by this isolate
+        std::vector<v8::Local<v8::ArrayBuffer>> transfers;
+        transfers.reserve(event.transfers.size());
+        for(auto& backingStore : event.transfers) transfers.push_back(v8::ArrayBuffer::New(isolate, backingStore));
+
         // Create a vector of the event arguments
         std::vector<v8::Local<v8::Value>> args;
-        args.reserve(event.second.size());
-        for(auto& arg : event.second)
+        args.reserve(event.args.size());
+        for(auto& arg : event.args)
         {
-            auto value = V8Helpers::Serialization::Deserialize(context, arg);
+            auto value = V8Helpers::Serialization::Deserialize(context, arg, transfers);
             if(value.IsEmpty())
             {
-                Log::Error << "Failed to deserialize worker event argument for event '" << event.first << "'" << Log::Endl;
+                Log::Error << "Failed to deserialize worker event argument for event '" << event.name << "'" << Log::Endl;
                 continue;
             }
             args.push_back(value.ToLocalChecked());
         }
         handlersLock.lock();
-        auto evHandlers = handlers.equal_range(event.first);
+        auto evHandlers = handlers.equal_range(event.name);
         queueLock.unlock();
 
         // Call all handlers with the arguments
         for(auto it = evHandlers.first; it != evHandlers.second; it++)
         {
-            V8Helpers::CallFunctionWithTimeout(it->second.fn.Get(isolate), context, args);
+            V8Helpers::CallFunctionWithTimeout(it->second.fn.Get(isolate), context, args, event.name);
             if(it->second.once) it->second.removed = true;
         }
         handlersLock.unlock();
@@ -82,13 +93,82 @@ void CEventHandler::Process()
         queueLock.lock();
         queue.pop();
         queueLock.unlock();
+
+        if(afterEvent) afterEvent();
+    }
+    processing = false;
+
+    if(resetPending)
+    {
+        resetPending = false;
+        Reset();
     }
 }
 
 void CEventHandler::Reset()
 {
+    // The handlers are still locked and iterated, and the current event is still in the queue
+    if(processing)
+    {
+        resetPending = true;
+        return;
+    }
+
     std::scoped_lock lock(queueLock);
     std::scoped_lock lock2(handlersLock);
     while(!queue.empty()) queue.pop();
     handlers.clear();
 }
+
+bool CEventHandler::SerializeArgs(const v8::FunctionCallbackInfo<v8::Value>& info,
+                                  int argsStart,
+                                  v8::Local<v8::Array> transferList,
+                                  std::vector<V8Helpers::Serialization::Value>& args,
+                                  Transfers& transfers)
+{
+    v8::Isolate* isolate = info.GetIsolate();
+    v8::Local<v8::Context> ctx = isolate->GetEnteredOrMicrotaskContext();
+
+    std::vector<v8::Local<v8::ArrayBuffer>> buffers;
+    if(!transferList.IsEmpty())
+    {
+        buffers.reserve(transferList->Length());
+        for(uint32_t i = 0; i < transferList->Length(); i++)
+        {
+            v8::Local<v8::Value> val;
+            if(!transferList->Get(ctx, i).ToLocal(&val) || !val->IsArrayBuffer())
+            {
+                V8Helpers::Throw(isolate, "Transfer list can only contain array buffers");
+                return false;
+            }
+            v8::Local<v8::ArrayBuffer> buffer = val.As<v8::ArrayBuffer>();
+            if(!buffer->IsDetachable() || buffer->WasDetached() || std::find(buffers.begin(), buffers.end(), buffer) != buffers.end())
+            {
+                V8Helpers::Throw(isolate, "Array buffer in transfer list can't be transferred");
+                return false;
+            }
+            buffers.push_back(buffer);
+        }
+    }
+
+    args.reserve(info.Length() - argsStart);
+    for(int i = argsStart; i < info.Length(); i++)
+    {
+        auto arg = V8Helpers::Serialization::Serialize(ctx, info[i], buffers);
+        if(!arg.Valid())
+        {
+            V8Helpers::Throw(isolate, "Invalid argument");
+            return false;
+        }
+        args.push_back(arg);
+    }
+
+    // Only detached after all arguments were serialized, so the buffers stay usable if serializing fails
+    transfers.reserve(buffers.size());
+    for(auto& buffer : buffers)
+    {
+        transfers.push_back(buffer->GetBackingStore());
+        buffer->Detach();
+    }
+    return true;
+}
@@ -3,13 +3,21 @@
 #include <queue>
 #include <string>
 #include <mutex>
+#include <functional>
 
 #include "V8Helpers.h"
 
 class CEventHandler
 {
 public:
-    using QueueItem = std::pair<std::string, std::vector<V8Helpers::Serialization::Value>>;
+    using Transfers = std::vector<std::shared_ptr<v8::BackingStore>>;
+    struct QueueItem
+    {
+        std::string name;
+        std::vector<V8Helpers::Serialization::Value> args;
+        // Backing stores of the array buffers that were transferred with the event
+        Transfers transfers;
+    };
     using Queue = std::queue<QueueItem>;
     using HandlerMap = std::unordered_multimap<std::string, V8Helpers::EventCallback>;
 
@@ -18,15 +26,41 @@ private:
     std::mutex queueLock;
     HandlerMap handlers;
     std::mutex handlersLock;
+    std::function<void()> emitCallback;
+    // Only used by the thread that processes the events, a reset from inside of a handler is done once Process returns
+    bool processing = false;
+    bool resetPending = false;
 
     void CleanupHandlers();
 
 public:
-    void Emit(const std::string& eventName, const std::vector<V8Helpers::Serialization::Value>& args);
+    void Emit(const std::string& eventName, const std::vector<V8Helpers::Serialization::Value>& args, Transfers&& transfers = {});
     void Subscribe(const std::string& eventName, v8::Local<v8::Function> callback, bool once = false);
     void Unsubscribe(const std::string& eventName, v8::Local<v8::Function> callback);
 
-    void Process();
+    // Called on the emitting thread after an event was queued
+    void SetEmitCallback(std::function<void()>&& callback)
+    {
+        std::scoped_lock lock(queueLock);
+        emitCallback = std::move(callback);
+    }
 
+    // afterEvent is called after the handlers of every event
+    void Process(const std::function<void()>& afterEvent = nullptr);
+
+    bool IsProcessing()
+    {
+        return processing;
+    }
+
+    // Has to be called on the thread that processes the events
     void Reset();
+
+    // Serializes the call arguments starting at argsStart, throws and returns false on failure.
+    // The array buffers in the transfer list are detached, their backing stores are moved to the receiver without copying them.
+    static bool SerializeArgs(const v8::FunctionCallbackInfo<v8::Value>& info,
+                              int argsStart,
+                              v8::Local<v8::Array> transferList,
+                              std::vector<V8Helpers::Serialization::Value>& args,
+                              Transfers& transfers);
 };
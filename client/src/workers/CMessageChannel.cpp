@@ -0,0 +1,45 @@
+#include "CMessageChannel.h"
+
+std::mutex CMessageChannel::channelsMutex;
+CMessageChannel::ChannelId CMessageChannel::nextChannelId = 0;
+std::unordered_map<CMessageChannel::ChannelId, std::shared_ptr<CMessageChannel>> CMessageChannel::channels;
+
+void CMessageChannel::Close(Side side)
+{
+    if(closed[side].exchange(true)) return;
+    // No more wakeups for this side, the queued events and handlers are dropped.
+    // When closed from one of its own handlers, they are dropped after that handler returned.
+    handlers[side].SetEmitCallback(nullptr);
+    handlers[side].Reset();
+}
+
+CMessageChannel::ChannelId CMessageChannel::Create()
+{
+    std::scoped_lock lock(channelsMutex);
+    ChannelId id = ++nextChannelId;
+    channels.insert({ id, std::make_shared<CMessageChannel>() });
+    return id;
+}
+
+bool CMessageChannel::Remove(ChannelId id)
+{
+    std::scoped_lock lock(channelsMutex);
+    // Ports that are already open keep their channel alive
+    return channels.erase(id) != 0;
+}
+
+std::shared_ptr<CMessageChannel> CMessageChannel::Open(ChannelId id, Side& side)
+{
+    std::scoped_lock lock(channelsMutex);
+    auto it = channels.find(id);
+    if(it == channels.end()) return nullptr;
+
+    std::shared_ptr<CMessageChannel> channel = it->second;
+    for(Side i = 0; i < 2; i++)
+    {
+        if(channel->opened[i].exchange(true)) continue;
+        side = i;
+        return channel;
+    }
+    return nullptr;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "CEventHandler.h"
+
+// Pair of event queues that connects two workers directly, without going through the main thread.
+// Channels are created by the main thread and registered by id, each side can be opened by exactly one worker.
+class CMessageChannel
+{
+public:
+    using ChannelId = uint32_t;
+    using Side = uint8_t;
+
+private:
+    // Incoming events of each side
+    std::array<CEventHandler, 2> handlers;
+    std::array<std::atomic<bool>, 2> opened{};
+    std::array<std::atomic<bool>, 2> closed{};
+
+    static std::mutex channelsMutex;
+    static ChannelId nextChannelId;
+    static std::unordered_map<ChannelId, std::shared_ptr<CMessageChannel>> channels;
+
+public:
+    CEventHandler& GetHandler(Side side)
+    {
+        return handlers[side];
+    }
+    bool IsClosed(Side side)
+    {
+        return closed[side];
+    }
+    // Has to be called on the thread that owns the side
+    void Close(Side side);
+
+    static ChannelId Create();
+    static bool Remove(ChannelId id);
+    // Opens the first side of the channel that is not opened yet, returns nullptr if both are already opened
+    static std::shared_ptr<CMessageChannel> Open(ChannelId id, Side& side);
+};
+
+// One end of a message channel, owned by the worker that opened it
+class CMessagePort
+{
+    std::shared_ptr<CMessageChannel> channel;
+    CMessageChannel::Side side;
+
+public:
+    CMessagePort(std::shared_ptr<CMessageChannel> channel, CMessageChannel::Side side) : channel(std::move(channel)), side(side) {}
+
+    CEventHandler& GetIncoming()
+    {
+        return channel->GetHandler(side);
+    }
+    CEventHandler& GetOutgoing()
+    {
+        return channel->GetHandler(side ^ 1);
+    }
+    bool IsClosed()
+    {
+        return channel->IsClosed(side);
+    }
+    bool IsPeerClosed()
+    {
+        return channel->IsClosed(side ^ 1);
+    }
+    void Close()
+    {
+        channel->Close(side);
+    }
+};
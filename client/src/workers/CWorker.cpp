@@ -6,11 +6,15 @@
 #include "V8Module.h"
 #include "WorkerTimer.h"
 #include "V8FastFunction.h"
-#include "JSBindings.h"
+#include "V8CodeCache.h"
+#include "CWorkerIsolatePool.h"
 
 #include <functional>
 
-CWorker::CWorker(std::string& filePath, CV8ResourceImpl* resource) : filePath(filePath), resource(resource) {}
+CWorker::CWorker(std::string& filePath, CV8ResourceImpl* resource) : filePath(filePath), resource(resource)
+{
+    workerEvents.SetEmitCallback([this]() { Wakeup(); });
+}
 
 void CWorker::Start()
 {
@@ -21,35 +25,75 @@ void CWorker::Start()
 
 void CWorker::Destroy()
 {
-    shouldTerminate = true;
+    // The worker thread could delete the worker while its handlers are still running, so this is done after they returned
+    if(GetMainEventHandler().IsProcessing())
+    {
+        destroyPending = true;
+        return;
+    }
+    destroyPending = false;
+
     if(isolate && !isPaused) CV8ScriptRuntime::Instance().RemoveActiveWorker();
+
+    // The main side handlers belong to the main isolate, so they are released here on the main thread
+    // and not when the worker thread deletes the worker
+    GetMainEventHandler().Reset();
+
+    // The worker thread deletes the worker as soon as it sees shouldTerminate, so nothing can be accessed after this
+    std::scoped_lock lock(wakeupMutex);
+    shouldTerminate = true;
+    wakeupPending = true;
+    wakeupCondition.notify_one();
+}
+
+void CWorker::Wakeup()
+{
+    std::scoped_lock lock(wakeupMutex);
+    wakeupPending = true;
+    wakeupCondition.notify_one();
+}
+
+bool CWorker::ShouldTerminate()
+{
+    std::scoped_lock lock(wakeupMutex);
+    return shouldTerminate;
+}
+
+void CWorker::WaitForWork()
+{
+    int64_t timeout = MAX_IDLE_WAIT;
+    if(!isPaused)
+    {
+        int64_t now = GetTime();
+        for(auto& [id, timer] : timers) timeout = std::min(timeout, timer->GetNextRun() - now);
+        // Timers without an interval would otherwise keep the thread busy
+        timeout = std::max<int64_t>(timeout, 1);
+    }
+
+    std::unique_lock lock(wakeupMutex);
+    wakeupCondition.wait_for(lock, std::chrono::milliseconds(timeout), [this]() { return wakeupPending; });
+    wakeupPending = false;
 }
 
 void CWorker::Thread()
 {
     bool result = Setup();
-    if(!result) shouldTerminate = true;
-    else
+    if(result)
     {
         // Isolate is set up, the worker is now ready
         isReady = true;
         std::vector<V8Helpers::Serialization::Value> args;
         GetMainEventHandler().Emit("load", args);
 
-        while(true)
-        {
-            // Sleep for a short while to not overload the thread
-            std::this_thread::sleep_for(std::chrono::microseconds(500));
-            if(!EventLoop()) break;
-        }
+        while(EventLoop()) WaitForWork();
     }
-    DestroyIsolate();
+    DestroyIsolate(result);
     delete this;  // ! IMPORTANT TO DO THIS LAST !
 }
 
 bool CWorker::EventLoop()
 {
-    if(shouldTerminate) return false;
+    if(ShouldTerminate()) return false;
     if(isPaused) return true;
 
     v8::Locker locker(isolate);
@@ -58,20 +102,42 @@ bool CWorker::EventLoop()
     v8::Context::Scope context_scope(context.Get(isolate));
 
     // Timers
-    for(auto& id : oldTimers) timers.erase(id);
+    for(auto& id : oldTimers)
+    {
+        auto it = timers.find(id);
+        if(it == timers.end()) continue;
+        delete it->second;
+        timers.erase(it);
+    }
     oldTimers.clear();
 
     auto error = TryCatch(
       [&]()
       {
-          // microtaskQueue->PerformCheckpoint(isolate); // todo: fix this
-          for(auto& p : timers)
+          // Callbacks can create timers, so the due timers are collected first
+          int64_t time = GetTime();
+          std::vector<TimerId> dueTimers;
+          for(auto& [id, timer] : timers)
           {
-              int64_t time = GetTime();
-              if(!p.second->Update(time)) RemoveTimer(p.first);
+              if(timer->GetNextRun() <= time) dueTimers.push_back(id);
           }
-          GetWorkerEventHandler().Process();
-          v8::platform::PumpMessageLoop(CV8ScriptRuntime::Instance().GetPlatform(), isolate);
+          for(TimerId id : dueTimers)
+          {
+              auto it = timers.find(id);
+              if(it == timers.end() || std::find(oldTimers.begin(), oldTimers.end(), id) != oldTimers.end()) continue;
+              if(!it->second->Update(GetTime())) RemoveTimer(id);
+              RunMicrotasks();
+          }
+
+          GetWorkerEventHandler().Process([this]() { RunMicrotasks(); });
+          // Handlers can open new ports, so they are accessed by index
+          for(size_t i = 0; i < messagePorts.size(); i++)
+          {
+              if(!messagePorts[i]->IsClosed()) messagePorts[i]->GetIncoming().Process([this]() { RunMicrotasks(); });
+          }
+
+          while(v8::platform::PumpMessageLoop(CV8ScriptRuntime::Instance().GetPlatform(), isolate)) RunMicrotasks();
+          RunMicrotasks();
       });
     if(!error.empty())
     {
@@ -83,9 +149,15 @@ bool CWorker::EventLoop()
     return true;
 }
 
+// Runs the promise continuations queued by the last task
+void CWorker::RunMicrotasks()
+{
+    microtaskQueue->PerformCheckpoint(isolate);
+}
+
 bool CWorker::Setup()
 {
-    SetupIsolate();
+    isolate = CWorkerIsolatePool::Instance().Acquire(microtaskQueue);
 
     // Set up locker and scopes
     v8::Locker locker(isolate);
@@ -99,12 +171,14 @@ bool CWorker::Setup()
     return SetupScript();
 }
 
-void CWorker::SetupIsolate()
+extern V8Module altWorker;
+extern V8Module altWorkerNatives;
+v8::Isolate* CWorker::CreateIsolate()
 {
     // Create the isolate
     v8::Isolate::CreateParams params;
     params.array_buffer_allocator = v8::ArrayBuffer::Allocator::NewDefaultAllocator();
-    isolate = v8::Isolate::New(params);
+    v8::Isolate* isolate = v8::Isolate::New(params);
 
     isolate->SetFatalErrorHandler([](const char* location, const char* message) { Log::Error << "[Worker] " << location << ": " << message << Log::Endl; });
 
@@ -163,8 +237,10 @@ void CWorker::SetupIsolate()
 
           CWorker* worker = static_cast<CWorker*>(context->GetAlignedPointerFromEmbedderData(2));
           std::string referrerName = *v8::String::Utf8Value(isolate, referrer->GetResourceName());
-          v8::Local<v8::Module> referrerModule = worker->GetModuleFromPath(referrerName);
-          if(referrerModule.IsEmpty() && referrerName != "<bootstrapper>") resolver->Reject(context, v8::Exception::ReferenceError(V8Helpers::JSValue("Could not resolve referrer module")));
+          v8::Local<v8::Module> referrerModule = worker ? worker->GetModuleFromPath(referrerName) : v8::Local<v8::Module>();
+          if(!worker) resolver->Reject(context, v8::Exception::ReferenceError(V8Helpers::JSValue("Worker was destroyed")));
+          else if(referrerModule.IsEmpty() && referrerName != "<bootstrapper>")
+              resolver->Reject(context, v8::Exception::ReferenceError(V8Helpers::JSValue("Could not resolve referrer module")));
           else
           {
               v8::MaybeLocal<v8::Module> maybeModule = CWorker::Import(context, specifier, assertions, referrerModule);
@@ -195,12 +271,32 @@ void CWorker::SetupIsolate()
 
     // IsWorker data slot
     isolate->SetData(v8::Isolate::GetNumberOfDataSlots() - 1, new bool(true));
+
+    {
+        v8::Locker locker(isolate);
+        v8::Isolate::Scope isolateScope(isolate);
+        v8::HandleScope handleScope(isolate);
+        V8Class::LoadAll(isolate);
+        V8Module::Add(isolate, altWorker, { "alt" });
+        V8Module::Add(isolate, altWorkerNatives);
+    }
+
+    return isolate;
+}
+
+void CWorker::DisposeIsolate(v8::Isolate* isolate)
+{
+    V8Module::Clear(isolate);
+    V8Class::UnloadAll(isolate);
+    V8FastFunction::UnloadAll(isolate);
+    delete static_cast<bool*>(isolate->GetData(v8::Isolate::GetNumberOfDataSlots() - 1));
+    v8::platform::NotifyIsolateShutdown(CV8ScriptRuntime::Instance().GetPlatform(), isolate);
+    isolate->Dispose();
 }
 
 void CWorker::SetupContext()
 {
-    // Create and set up the context
-    microtaskQueue = v8::MicrotaskQueue::New(isolate, v8::MicrotasksPolicy::kExplicit);
+    // Create and set up the context, the microtask queue comes with the isolate
     auto ctx = v8::Context::New(isolate, nullptr, v8::MaybeLocal<v8::ObjectTemplate>(), v8::MaybeLocal<v8::Value>(), v8::DeserializeInternalFieldsCallback(), microtaskQueue.get());
     context.Reset(isolate, ctx);
     v8::Context::Scope scope(ctx);
@@ -217,10 +313,7 @@ bool CWorker::SetupScript()
       [&]()
       {
           v8::Local<v8::Context> ctx = context.Get(isolate);
-          v8::MaybeLocal<v8::Module> maybeModule;
-          v8::ScriptOrigin scriptOrigin(isolate, V8Helpers::JSValue("<bootstrapper>"), 0, 0, false, -1, v8::Local<v8::Value>(), false, false, true, v8::Local<v8::PrimitiveArray>());
-          v8::ScriptCompiler::Source source{ V8Helpers::JSValue(bootstrap_code), scriptOrigin };
-          maybeModule = v8::ScriptCompiler::CompileModule(isolate, &source);
+          v8::MaybeLocal<v8::Module> maybeModule = V8CodeCache::CompileModule(isolate, "<bootstrapper>", bootstrap_code);
 
           if(maybeModule.IsEmpty())
           {
@@ -247,6 +340,8 @@ bool CWorker::SetupScript()
               failed = true;
               return;
           }
+
+          V8CodeCache::SaveUserModules(isolate, pendingCodeCaches);
       });
     if(!error.empty() || failed)
     {
@@ -257,30 +352,44 @@ bool CWorker::SetupScript()
     return true;
 }
 
-void CWorker::DestroyIsolate()
+void CWorker::DestroyIsolate(bool reusable)
 {
     while(isolate->IsInUse()) isolate->Exit();
-    V8Module::Clear(isolate);
-    V8Class::UnloadAll(isolate);
-    V8FastFunction::UnloadAll(isolate);
-    context.Reset();
-    GetMainEventHandler().Reset();
-    GetWorkerEventHandler().Reset();
-    v8::platform::NotifyIsolateShutdown(CV8ScriptRuntime::Instance().GetPlatform(), isolate);
-    isolate->Dispose();
+    v8::Global<v8::Context> oldContext;
+    {
+        // All handles of the worker are released, so the isolate can be reused by the next worker.
+        // CPersistent doesn't reset on destruction, so they are reset explicitly.
+        v8::Locker locker(isolate);
+        v8::Isolate::Scope isolateScope(isolate);
+        v8::HandleScope handleScope(isolate);
+        for(auto& [id, timer] : timers) delete timer;
+        timers.clear();
+        oldTimers.clear();
+        for(auto& [name, module] : modules) module.mod.Reset();
+        modules.clear();
+        for(auto& [name, value] : requiresMap) value.Reset();
+        requiresMap.clear();
+        pendingCodeCaches.clear();
+        promiseRejections.Clear();
+        GetWorkerEventHandler().Reset();
+        // The incoming handlers of the ports belong to this isolate
+        for(auto& port : messagePorts) port->Close();
+        messagePorts.clear();
+
+        // Tasks that still run for the old context must not find the worker anymore
+        v8::Local<v8::Context> ctx = context.Get(isolate);
+        ctx->SetAlignedPointerInEmbedderData(2, nullptr);
+        oldContext.Reset(isolate, ctx);
+        context.Reset();
+    }
+    CWorkerIsolatePool::Instance().Release(isolate, std::move(microtaskQueue), std::move(oldContext), reusable);
 }
 
 extern void StaticRequire(const v8::FunctionCallbackInfo<v8::Value>& info);
-extern V8Module altWorker;
-extern V8Module altWorkerNatives;
 void CWorker::SetupGlobals()
 {
     v8::Local<v8::Object> global = context.Get(isolate)->Global();
 
-    V8Class::LoadAll(isolate);
-    V8Module::Add(isolate, altWorker, { "alt" });
-    V8Module::Add(isolate, altWorkerNatives);
-
     auto alt = altWorker.GetExports(isolate, context.Get(isolate));
     auto console = global->Get(context.Get(isolate), V8Helpers::JSValue("console")).ToLocalChecked().As<v8::Object>();
     if(!console.IsEmpty())
@@ -298,13 +407,14 @@ void CWorker::SetupGlobals()
     V8Helpers::RegisterFunc(global, "clearTimeout", &ClearTimer);
 
     global->Set(context.Get(isolate), V8Helpers::JSValue("__internal_get_exports"), v8::Function::New(context.Get(isolate), &StaticRequire).ToLocalChecked());
-    global->Set(context.Get(isolate), V8Helpers::JSValue("__internal_bindings_code"), V8Helpers::JSValue(JSBindings::GetBindingsCode()));
+    global->Set(context.Get(isolate), V8Helpers::JSValue("__internal_load_bindings"), v8::Function::New(context.Get(isolate), &V8CodeCache::LoadBindings).ToLocalChecked());
     global->Set(context.Get(isolate), V8Helpers::JSValue("__internal_main_path"), V8Helpers::JSValue(filePath));
 }
 
 v8::MaybeLocal<v8::Module> CWorker::Import(v8::Local<v8::Context> context, v8::Local<v8::String> specifier, v8::Local<v8::FixedArray>, v8::Local<v8::Module> referrer)
 {
     CWorker* worker = static_cast<CWorker*>(context->GetAlignedPointerFromEmbedderData(2));
+    if(!worker) return v8::MaybeLocal<v8::Module>();
     std::string importName = *v8::String::Utf8Value(worker->GetIsolate(), specifier);
     alt::IResource* resource = worker->GetResource()->GetResource();
 
@@ -370,25 +480,43 @@ std::string CWorker::TryCatch(const std::function<void()>& func)
         return std::string();
 }
 
-// Shared array buffers
+CMessagePort* CWorker::OpenMessagePort(CMessageChannel::ChannelId id)
+{
+    CMessageChannel::Side side;
+    std::shared_ptr<CMessageChannel> channel = CMessageChannel::Open(id, side);
+    if(!channel) return nullptr;
+
+    CMessagePort* port = messagePorts.emplace_back(std::make_unique<CMessagePort>(channel, side)).get();
+    port->GetIncoming().SetEmitCallback([this]() { Wakeup(); });
+    return port;
+}
+
+// Shared array buffers, accessed from the main thread and all workers
+std::mutex CWorker::sharedArrayBuffersMutex;
 CWorker::BufferId CWorker::nextBufferId = 0;
 std::unordered_map<CWorker::BufferId, std::shared_ptr<v8::BackingStore>> CWorker::sharedArrayBuffers = std::unordered_map<CWorker::BufferId, std::shared_ptr<v8::BackingStore>>();
 
 CWorker::BufferId CWorker::AddSharedArrayBuffer(v8::Local<v8::SharedArrayBuffer> buffer)
 {
+    std::scoped_lock lock(sharedArrayBuffersMutex);
     BufferId id = ++nextBufferId;
     sharedArrayBuffers.insert({ id, buffer->GetBackingStore() });
     return id;
 }
 bool CWorker::RemoveSharedArrayBuffer(CWorker::BufferId index)
 {
-    if(sharedArrayBuffers.count(index) == 0) return false;
-    sharedArrayBuffers.erase(index);
-    return true;
+    std::scoped_lock lock(sharedArrayBuffersMutex);
+    return sharedArrayBuffers.erase(index) != 0;
 }
 
 v8::Local<v8::SharedArrayBuffer> CWorker::GetSharedArrayBuffer(v8::Isolate* isolate, CWorker::BufferId index)
 {
-    if(sharedArrayBuffers.count(index) == 0) return v8::Local<v8::SharedArrayBuffer>();
-    return v8::SharedArrayBuffer::New(isolate, sharedArrayBuffers.at(index));
+    std::shared_ptr<v8::BackingStore> backingStore;
+    {
+        std::scoped_lock lock(sharedArrayBuffersMutex);
+        auto it = sharedArrayBuffers.find(index);
+        if(it == sharedArrayBuffers.end()) return v8::Local<v8::SharedArrayBuffer>();
+        backingStore = it->second;
+    }
+    return v8::SharedArrayBuffer::New(isolate, backingStore);
 }
@@ -3,6 +3,7 @@
 #include "V8Helpers.h"
 #include "WorkerPromiseRejections.h"
 #include "CEventHandler.h"
+#include "CMessageChannel.h"
 #include "../IImportHandler.h"
 
 #include <string>
@@ -10,6 +11,9 @@
 #include <map>
 #include <queue>
 #include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 class CV8ResourceImpl;
 class WorkerTimer;
@@ -27,12 +31,21 @@ private:
     std::string filePath;
     std::thread thread;
     CV8ResourceImpl* resource;
+    std::atomic<bool> isReady = false;
+    std::atomic<bool> isPaused = false;
+
+    // Guards shouldTerminate, so the worker can't delete itself while Destroy is still running
+    std::mutex wakeupMutex;
+    std::condition_variable wakeupCondition;
+    bool wakeupPending = false;
     bool shouldTerminate = false;
-    bool isReady = false;
-    bool isPaused = false;
+    // Destroy was called from one of the main side handlers, only accessed by the main thread
+    bool destroyPending = false;
 
     CEventHandler mainEvents;
     CEventHandler workerEvents;
+    // Ports are only closed and not removed, their JS objects point to them until the isolate is destroyed
+    std::vector<std::unique_ptr<CMessagePort>> messagePorts;
 
     WorkerPromiseRejections promiseRejections;
 
@@ -44,23 +57,32 @@ private:
     std::vector<TimerId> oldTimers;
     std::unordered_map<TimerId, WorkerTimer*> timers;
 
+    static std::mutex sharedArrayBuffersMutex;
     static BufferId nextBufferId;
     static std::unordered_map<BufferId, std::shared_ptr<v8::BackingStore>> sharedArrayBuffers;
 
     void Thread();
 
     bool EventLoop();
+    void RunMicrotasks();
+    // Blocks until the worker is woken up or the next timer is due
+    void WaitForWork();
+    void Wakeup();
+    bool ShouldTerminate();
 
     bool Setup();
-    void SetupIsolate();
     void SetupContext();
     void SetupGlobals();
     bool SetupScript();
 
-    void DestroyIsolate();
+    // The isolate is only given back to the pool for reuse if the worker was running
+    void DestroyIsolate(bool reusable);
 
     void EmitError(const std::string& error);
 
+    // Upper limit for how long an idle worker sleeps, so tasks posted to the isolate by the platform still run
+    static constexpr int64_t MAX_IDLE_WAIT = 16;
+
     static inline int64_t GetTime()
     {
         return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
@@ -80,8 +102,12 @@ public:
     void Resume()
     {
         isPaused = false;
+        Wakeup();
     }
 
+    // Returns nullptr if the channel does not exist or both of its sides are already opened
+    CMessagePort* OpenMessagePort(CMessageChannel::ChannelId id);
+
     TimerId CreateTimer(v8::Local<v8::Function> callback, uint32_t interval, bool once, V8Helpers::SourceLocation&& location);
     void RemoveTimer(TimerId id)
     {
@@ -100,6 +126,10 @@ public:
     {
         return isPaused;
     }
+    bool IsDestroyPending()
+    {
+        return destroyPending;
+    }
     v8::Isolate* GetIsolate()
     {
         return isolate;
@@ -127,6 +157,10 @@ public:
         promiseRejections.HandlerAdded(this, data);
     }
 
+    // Creates an isolate with the worker callbacks, class templates and modules set up, used by the isolate pool
+    static v8::Isolate* CreateIsolate();
+    static void DisposeIsolate(v8::Isolate* isolate);
+
     static v8::MaybeLocal<v8::Module> Import(v8::Local<v8::Context> context, v8::Local<v8::String> specifier, v8::Local<v8::FixedArray>, v8::Local<v8::Module> referrer);
 
     // Returns error or empty string
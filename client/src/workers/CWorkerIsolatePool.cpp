@@ -0,0 +1,148 @@
+#include "CWorkerIsolatePool.h"
+#include "CWorker.h"
+#include "libplatform/libplatform.h"
+#include "../CV8ScriptRuntime.h"
+
+CWorkerIsolatePool::Entry CWorkerIsolatePool::Create()
+{
+    Entry entry;
+    entry.isolate = CWorker::CreateIsolate();
+    v8::Locker locker(entry.isolate);
+    v8::Isolate::Scope isolateScope(entry.isolate);
+    entry.microtaskQueue = v8::MicrotaskQueue::New(entry.isolate, v8::MicrotasksPolicy::kExplicit);
+    return entry;
+}
+
+void CWorkerIsolatePool::Dispose(Entry& entry)
+{
+    {
+        v8::Locker locker(entry.isolate);
+        v8::Isolate::Scope isolateScope(entry.isolate);
+        entry.microtaskQueue.reset();
+    }
+    CWorker::DisposeIsolate(entry.isolate);
+    entry.isolate = nullptr;
+}
+
+void CWorkerIsolatePool::SetSize(size_t _size)
+{
+    std::vector<Entry> removed;
+    {
+        std::scoped_lock lock(mutex);
+        size = _size;
+        while(entries.size() > size)
+        {
+            removed.push_back(std::move(entries.back()));
+            entries.pop_back();
+        }
+    }
+    for(Entry& entry : removed) Dispose(entry);
+}
+
+v8::Isolate* CWorkerIsolatePool::Acquire(std::unique_ptr<v8::MicrotaskQueue>& microtaskQueue)
+{
+    Entry entry;
+    {
+        std::scoped_lock lock(mutex);
+        used = true;
+        if(!entries.empty())
+        {
+            entry = std::move(entries.back());
+            entries.pop_back();
+        }
+        StartRefill();
+    }
+    if(!entry.isolate) entry = Create();
+
+    microtaskQueue = std::move(entry.microtaskQueue);
+    return entry.isolate;
+}
+
+void CWorkerIsolatePool::Release(v8::Isolate* isolate, std::unique_ptr<v8::MicrotaskQueue> microtaskQueue, v8::Global<v8::Context> context, bool reusable)
+{
+    Entry entry{ isolate, std::move(microtaskQueue) };
+    bool reuse;
+    {
+        std::scoped_lock lock(mutex);
+        // A terminated isolate might still unwind the next script that runs in it
+        reuse = reusable && !stopping && entries.size() < size && !isolate->IsExecutionTerminating();
+    }
+
+    {
+        v8::Locker locker(isolate);
+        v8::Isolate::Scope isolateScope(isolate);
+        if(reuse)
+        {
+            // Tasks the platform still has queued for the old context, the worker is already unset in it
+            while(v8::platform::PumpMessageLoop(CV8ScriptRuntime::Instance().GetPlatform(), isolate)) continue;
+
+            // Collects the context of the previous worker, so the next one starts with a small heap
+            context.SetWeak();
+            isolate->ContextDisposedNotification();
+            isolate->LowMemoryNotification();
+
+            // Microtasks and delayed tasks that are left keep the old context alive
+            reuse = context.IsEmpty() && !entry.microtaskQueue->IsRunningMicrotasks() && !isolate->IsExecutionTerminating();
+        }
+        context.Reset();
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        if(reuse && !stopping && entries.size() < size)
+        {
+            entries.push_back(std::move(entry));
+            return;
+        }
+    }
+    Dispose(entry);
+}
+
+void CWorkerIsolatePool::StartRefill()
+{
+    if(refilling || stopping || !used || entries.size() >= size) return;
+    // The previous refill thread has already finished its work
+    if(refillThread.joinable()) refillThread.join();
+    refilling = true;
+    refillThread = std::thread(&CWorkerIsolatePool::Refill, this);
+}
+
+void CWorkerIsolatePool::Refill()
+{
+    while(true)
+    {
+        {
+            std::scoped_lock lock(mutex);
+            if(stopping || entries.size() >= size)
+            {
+                refilling = false;
+                return;
+            }
+        }
+
+        Entry entry = Create();
+
+        std::unique_lock lock(mutex);
+        if(stopping || entries.size() >= size)
+        {
+            refilling = false;
+            lock.unlock();
+            Dispose(entry);
+            return;
+        }
+        entries.push_back(std::move(entry));
+    }
+}
+
+void CWorkerIsolatePool::Shutdown()
+{
+    std::vector<Entry> removed;
+    {
+        std::scoped_lock lock(mutex);
+        stopping = true;
+        removed = std::move(entries);
+        entries.clear();
+    }
+    if(refillThread.joinable()) refillThread.join();
+    for(Entry& entry : removed) Dispose(entry);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "v8.h"
+
+// Idle worker isolates that already have the isolate callbacks, class templates and modules set up,
+// so a starting worker only has to create its context. Isolates of terminated workers are reused.
+// The pool is only filled after the first worker was started, so clients without workers don't pay for it.
+class CWorkerIsolatePool
+{
+    // The microtask queue stays with the isolate, the contexts of previous workers might still point to it
+    struct Entry
+    {
+        v8::Isolate* isolate = nullptr;
+        std::unique_ptr<v8::MicrotaskQueue> microtaskQueue;
+    };
+
+    std::mutex mutex;
+    std::vector<Entry> entries;
+    size_t size = 2;
+    bool used = false;
+    bool refilling = false;
+    bool stopping = false;
+    std::thread refillThread;
+
+    static Entry Create();
+    static void Dispose(Entry& entry);
+
+    void StartRefill();
+    // Creates isolates on a background thread, until the pool is full
+    void Refill();
+
+public:
+    static CWorkerIsolatePool& Instance()
+    {
+        // Never destroyed, the isolates are disposed by Shutdown when the runtime is disposed
+        static CWorkerIsolatePool* instance = new CWorkerIsolatePool();
+        return *instance;
+    }
+
+    // Number of idle isolates that are kept, 0 disables the pool
+    void SetSize(size_t size);
+
+    // Returns an idle isolate, or creates a new one if the pool is empty
+    v8::Isolate* Acquire(std::unique_ptr<v8::MicrotaskQueue>& microtaskQueue);
+    // Has to be called without any handles of the previous worker left in the isolate, except for the weak context.
+    // The pending tasks of the isolate are run first, then the isolate is only reused if the old context was collected.
+    // The microtask queue keeps the contexts of its microtasks alive, so then it is empty.
+    void Release(v8::Isolate* isolate, std::unique_ptr<v8::MicrotaskQueue> microtaskQueue, v8::Global<v8::Context> context, bool reusable);
+
+    void Shutdown();
+};
@@ -8,29 +8,38 @@ void Emit(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN_MIN(1);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_STRING(1, eventName);
 
     std::vector<V8Helpers::Serialization::Value> args;
-    args.reserve(info.Length() - 1);
-    for(int i = 1; i < info.Length(); i++)
-    {
-        auto arg = V8Helpers::Serialization::Serialize(ctx, info[i]);
-        if(!arg.Valid())
-        {
-            V8Helpers::Throw(isolate, "Invalid argument");
-            return;
-        }
-        args.push_back(arg);
-    }
+    CEventHandler::Transfers transfers;
+    if(!CEventHandler::SerializeArgs(info, 1, v8::Local<v8::Array>(), args, transfers)) return;
     worker->GetMainEventHandler().Emit(eventName, args);
 }
 
+void EmitTransfer(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN_MIN(2);
+    auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
+
+    V8_ARG_TO_STRING(1, eventName);
+    V8_ARG_TO_ARRAY(2, transferList);
+
+    std::vector<V8Helpers::Serialization::Value> args;
+    CEventHandler::Transfers transfers;
+    if(!CEventHandler::SerializeArgs(info, 2, transferList, args, transfers)) return;
+    worker->GetMainEventHandler().Emit(eventName, args, std::move(transfers));
+}
+
 void On(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(2);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_STRING(1, eventName);
     V8_ARG_TO_FUNCTION(2, callback);
@@ -43,6 +52,7 @@ void Off(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(2);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_STRING(1, eventName);
     V8_ARG_TO_FUNCTION(2, callback);
@@ -55,6 +65,7 @@ void Once(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(2);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_STRING(1, eventName);
     V8_ARG_TO_FUNCTION(2, callback);
@@ -67,6 +78,7 @@ void NextTick(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(1);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_FUNCTION(1, callback);
 
@@ -78,6 +90,7 @@ void SetTimeout(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(2);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_FUNCTION(1, callback);
     V8_ARG_TO_UINT(2, time);
@@ -90,6 +103,7 @@ void SetInterval(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(2);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_FUNCTION(1, callback);
     V8_ARG_TO_UINT(2, time);
@@ -102,6 +116,7 @@ void ClearTimer(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(1);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_UINT(1, timer);
 
@@ -113,6 +128,7 @@ void GetSharedArrayBuffer(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(1);
     auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
 
     V8_ARG_TO_UINT(1, index);
 
@@ -121,11 +137,29 @@ void GetSharedArrayBuffer(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_RETURN(buffer);
 }
 
+extern V8Class v8MessagePort;
+void OpenMessagePort(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN(1);
+    auto worker = static_cast<CWorker*>(ctx->GetAlignedPointerFromEmbedderData(2));
+    V8_CHECK(worker, "Worker was destroyed");
+
+    V8_ARG_TO_UINT(1, id);
+
+    CMessagePort* port = worker->OpenMessagePort(id);
+    V8_CHECK(port, "Invalid message channel id or the channel is already opened by two workers");
+
+    v8::Local<v8::Object> obj = v8MessagePort.CreateInstance(ctx);
+    obj->SetInternalField(0, v8::External::New(isolate, port));
+    V8_RETURN(obj);
+}
+
 extern V8Module altModule;
 extern V8Class v8File, v8RGBA, v8Vector2, v8Vector3, v8Utils, v8Resource;
 extern V8Module altWorker("alt-worker",
                           nullptr,
-                          { v8File, v8RGBA, v8Vector2, v8Vector3, v8Utils, v8Resource },
+                          { v8File, v8RGBA, v8Vector2, v8Vector3, v8Utils, v8Resource, v8MessagePort },
                           [](v8::Local<v8::Context> ctx, v8::Local<v8::Object> exports)
                           {
                               v8::Isolate* isolate = ctx->GetIsolate();
@@ -139,6 +173,7 @@ extern V8Module altWorker("alt-worker",
                               };
 
                               V8Helpers::RegisterFunc(exports, "emit", &Emit);
+                              V8Helpers::RegisterFunc(exports, "emitTransfer", &EmitTransfer);
                               V8Helpers::RegisterFunc(exports, "on", &On);
                               V8Helpers::RegisterFunc(exports, "off", &Off);
                               V8Helpers::RegisterFunc(exports, "once", &Once);
@@ -150,6 +185,7 @@ extern V8Module altWorker("alt-worker",
                               V8Helpers::RegisterFunc(exports, "clearTimeout", &ClearTimer);
                               V8Helpers::RegisterFunc(exports, "clearTimer", &ClearTimer);
                               V8Helpers::RegisterFunc(exports, "getSharedArrayBuffer", &::GetSharedArrayBuffer);
+                              V8Helpers::RegisterFunc(exports, "openMessagePort", &OpenMessagePort);
 
                               V8_OBJECT_SET_BOOLEAN(exports, "isWorker", true);
 
@@ -2,6 +2,7 @@
 #include "v8.h"
 
 void Emit(const v8::FunctionCallbackInfo<v8::Value>& info);
+void EmitTransfer(const v8::FunctionCallbackInfo<v8::Value>& info);
 void On(const v8::FunctionCallbackInfo<v8::Value>& info);
 void Once(const v8::FunctionCallbackInfo<v8::Value>& info);
 
@@ -11,3 +12,4 @@ void SetInterval(const v8::FunctionCallbackInfo<v8::Value>& info);
 void ClearTimer(const v8::FunctionCallbackInfo<v8::Value>& info);
 
 void GetSharedArrayBuffer(const v8::FunctionCallbackInfo<v8::Value>& info);
+void OpenMessagePort(const v8::FunctionCallbackInfo<v8::Value>& info);
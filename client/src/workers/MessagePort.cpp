@@ -0,0 +1,108 @@
+#include "V8Helpers.h"
+#include "V8Class.h"
+#include "CMessageChannel.h"
+
+static void Emit(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN_MIN(1);
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+    V8_CHECK(!port->IsClosed(), "Message port is closed");
+    V8_CHECK(!port->IsPeerClosed(), "The other side of the message port is closed");
+
+    V8_ARG_TO_STRING(1, eventName);
+
+    std::vector<V8Helpers::Serialization::Value> args;
+    CEventHandler::Transfers transfers;
+    if(!CEventHandler::SerializeArgs(info, 1, v8::Local<v8::Array>(), args, transfers)) return;
+    port->GetOutgoing().Emit(eventName, args);
+}
+
+static void EmitTransfer(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN_MIN(2);
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+    V8_CHECK(!port->IsClosed(), "Message port is closed");
+    V8_CHECK(!port->IsPeerClosed(), "The other side of the message port is closed");
+
+    V8_ARG_TO_STRING(1, eventName);
+    V8_ARG_TO_ARRAY(2, transferList);
+
+    std::vector<V8Helpers::Serialization::Value> args;
+    CEventHandler::Transfers transfers;
+    if(!CEventHandler::SerializeArgs(info, 2, transferList, args, transfers)) return;
+    port->GetOutgoing().Emit(eventName, args, std::move(transfers));
+}
+
+static void On(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN(2);
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+    V8_CHECK(!port->IsClosed(), "Message port is closed");
+
+    V8_ARG_TO_STRING(1, eventName);
+    V8_ARG_TO_FUNCTION(2, callback);
+
+    port->GetIncoming().Subscribe(eventName, callback);
+}
+
+static void Once(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN(2);
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+    V8_CHECK(!port->IsClosed(), "Message port is closed");
+
+    V8_ARG_TO_STRING(1, eventName);
+    V8_ARG_TO_FUNCTION(2, callback);
+
+    port->GetIncoming().Subscribe(eventName, callback, true);
+}
+
+static void Off(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK_ARGS_LEN(2);
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+    V8_CHECK(!port->IsClosed(), "Message port is closed");
+
+    V8_ARG_TO_STRING(1, eventName);
+    V8_ARG_TO_FUNCTION(2, callback);
+
+    port->GetIncoming().Unsubscribe(eventName, callback);
+}
+
+static void Close(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+
+    port->Close();
+}
+
+static void ClosedGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE();
+    V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, port, CMessagePort);
+
+    V8_RETURN_BOOLEAN(port->IsClosed() || port->IsPeerClosed());
+}
+
+// Only created by alt.openMessagePort in workers
+extern V8Class v8MessagePort("MessagePort",
+                             [](v8::Local<v8::FunctionTemplate> tpl)
+                             {
+                                 v8::Isolate* isolate = v8::Isolate::GetCurrent();
+                                 tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+                                 V8Helpers::SetAccessor(isolate, tpl, "closed", ClosedGetter);
+
+                                 V8Helpers::SetMethod(isolate, tpl, "emit", Emit);
+                                 V8Helpers::SetMethod(isolate, tpl, "emitTransfer", EmitTransfer);
+                                 V8Helpers::SetMethod(isolate, tpl, "on", On);
+                                 V8Helpers::SetMethod(isolate, tpl, "once", Once);
+                                 V8Helpers::SetMethod(isolate, tpl, "off", Off);
+                                 V8Helpers::SetMethod(isolate, tpl, "close", Close);
+                             });
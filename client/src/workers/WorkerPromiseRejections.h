@@ -11,6 +11,12 @@ struct WorkerPromiseRejection
     V8Helpers::SourceLocation location;
 
     WorkerPromiseRejection(v8::Isolate* isolate, v8::Local<v8::Promise> promise, v8::Local<v8::Value> value, V8Helpers::SourceLocation&& location);
+    ~WorkerPromiseRejection()
+    {
+        // CPersistent doesn't reset on destruction
+        promise.Reset();
+        value.Reset();
+    }
 };
 
 class WorkerPromiseRejections
@@ -19,6 +25,10 @@ public:
     void RejectedWithNoHandler(CWorker* worker, v8::PromiseRejectMessage& data);
     void HandlerAdded(CWorker* worker, v8::PromiseRejectMessage& data);
     void ProcessQueue(CWorker* worker);
+    void Clear()
+    {
+        queue.clear();
+    }
 
 private:
     std::vector<std::unique_ptr<WorkerPromiseRejection>> queue;
@@ -18,13 +18,20 @@ public:
     {
     }
 
+    ~WorkerTimer()
+    {
+        // CPersistent doesn't reset on destruction
+        context.Reset();
+        callback.Reset();
+    }
+
     bool Update(int64_t curTime)
     {
         if(curTime - lastRun >= interval)
         {
             auto result = CWorker::TryCatch([&] {
                 std::vector<v8::Local<v8::Value>> args;
-                V8Helpers::CallFunctionWithTimeout(callback.Get(isolate), context.Get(isolate), args);
+                V8Helpers::CallFunctionWithTimeout(callback.Get(isolate), context.Get(isolate), args, once ? "setTimeout callback" : "setInterval callback");
             });
             if(!result.empty()) worker->EmitError(result);
 
@@ -36,6 +43,11 @@ public:
         return true;
     }
 
+    int64_t GetNextRun() const
+    {
+        return lastRun + interval;
+    }
+
     const V8Helpers::SourceLocation& GetLocation() const
     {
         return location;
@@ -0,0 +1,160 @@
+#include "stdafx.h"
+
+#include "V8Helpers.h"
+#include "V8TimerWheel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Standalone benchmarks of the parts of the module that don't call into the server core,
+// usage: js-module-bench [iterations]
+// The paths that need the core (events, MValues, pools) are measured by "js-module --bench" on a running server.
+
+static uint32_t iterations = 100000;
+
+template<typename Func>
+static void Bench(v8::Isolate* isolate, const char* name, Func&& fn, uint32_t count = iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(uint32_t i = 0; i < count; i++)
+    {
+        v8::HandleScope iterationScope(isolate);
+        fn();
+    }
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::printf("  %s: %.1fns/op\n", name, ns / count);
+}
+
+// The loop the resource tick used before the timing wheel, every timer is checked on every tick
+struct LinearTimers
+{
+    std::unordered_map<uint32_t, V8Timer*> timers;
+    std::vector<uint32_t> oldTimers;
+
+    ~LinearTimers()
+    {
+        for(auto& [id, timer] : timers) delete timer;
+    }
+
+    void Update(int64_t time)
+    {
+        for(auto& id : oldTimers)
+        {
+            delete timers[id];
+            timers.erase(id);
+        }
+        oldTimers.clear();
+
+        for(auto& [id, timer] : timers)
+        {
+            if(std::find(oldTimers.begin(), oldTimers.end(), id) != oldTimers.end()) continue;
+            if(!timer->Update(time)) oldTimers.push_back(id);
+        }
+    }
+};
+
+// Ticks of 1ms with timers of 1 to 2 seconds interval, so most of the timers are idle and every timer runs about once
+static void BenchTimerTick(v8::Isolate* isolate, v8::Local<v8::Context> ctx, v8::Local<v8::Function> callback, uint32_t count)
+{
+    uint32_t ticks = std::min<uint32_t>(iterations, 2000);
+    std::string name;
+
+    {
+        int64_t time = 0;
+        V8TimerWheel wheel(time);
+        for(uint32_t i = 0; i < count; i++) wheel.Add(isolate, ctx, time, callback, 1000 + i % 1000, false, V8Helpers::SourceLocation("benchmark", 0, ctx));
+        name = "Timer tick, wheel (" + std::to_string(count) + " timers)";
+        Bench(
+          isolate,
+          name.c_str(),
+          [&]
+          {
+              time++;
+              wheel.Update(time, [&](uint32_t, V8Timer& timer) { return timer.Update(time); });
+          },
+          ticks);
+        wheel.Clear();
+    }
+
+    {
+        int64_t time = 0;
+        LinearTimers linear;
+        for(uint32_t i = 0; i < count; i++) linear.timers[i] = new V8Timer(isolate, ctx, time, callback, 1000 + i % 1000, false, V8Helpers::SourceLocation("benchmark", 0, ctx));
+        name = "Timer tick, linear (" + std::to_string(count) + " timers)";
+        Bench(isolate, name.c_str(), [&] { linear.Update(++time); }, ticks);
+    }
+}
+
+static void BenchTimers(v8::Isolate* isolate, v8::Local<v8::Context> ctx)
+{
+    v8::Local<v8::Function> callback = v8::Function::New(ctx, [](const v8::FunctionCallbackInfo<v8::Value>&) {}).ToLocalChecked();
+    int64_t time = 0;
+    V8TimerWheel wheel(time);
+
+    Bench(isolate, "Timer create/remove", [&] { wheel.Remove(wheel.Add(isolate, ctx, time, callback, 1000, true, V8Helpers::SourceLocation("benchmark", 0, ctx))); });
+    wheel.Clear();
+
+    for(uint32_t count : { 1000, 10000, 100000 }) BenchTimerTick(isolate, ctx, callback, count);
+
+    // Timers that are due every tick, the wheel can't skip any of them
+    for(uint32_t i = 0; i < 1000; i++) wheel.Add(isolate, ctx, time, callback, 1, false, V8Helpers::SourceLocation("benchmark", 0, ctx));
+    Bench(isolate,
+          "Timer tick, wheel (1000 due timers)",
+          [&]
+          {
+              time++;
+              wheel.Update(time, [&](uint32_t, V8Timer& timer) { return timer.Update(time); });
+          });
+    wheel.Clear();
+}
+
+static void BenchSerialization(v8::Isolate* isolate, v8::Local<v8::Context> ctx)
+{
+    v8::Local<v8::Object> obj = v8::Object::New(isolate);
+    obj->Set(ctx, V8Helpers::JSValue("id"), V8Helpers::JSValue(1));
+    obj->Set(ctx, V8Helpers::JSValue("name"), V8Helpers::JSValue("benchmark"));
+    obj->Set(ctx, V8Helpers::JSValue("list"), v8::Array::New(isolate, 16));
+
+    Bench(isolate, "Serialize", [&] { V8Helpers::Serialization::Serialize(ctx, obj); });
+    V8Helpers::Serialization::Value value = V8Helpers::Serialization::Serialize(ctx, obj);
+    Bench(isolate, "Deserialize", [&] { V8Helpers::Serialization::Deserialize(ctx, value, {}); });
+}
+
+int main(int argc, char** argv)
+{
+    if(argc > 1) iterations = std::max<uint32_t>((uint32_t)std::strtoul(argv[1], nullptr, 10), 1);
+
+    std::vector<std::string> args = { "js-module-bench" };
+    std::vector<std::string> execArgs;
+    std::vector<std::string> errors;
+    node::InitializeNodeWithArgs(&args, &execArgs, &errors);
+
+    std::unique_ptr<node::MultiIsolatePlatform> platform = node::MultiIsolatePlatform::Create(1);
+    v8::V8::InitializePlatform(platform.get());
+    v8::V8::Initialize();
+
+    v8::Isolate* isolate = node::NewIsolate(node::CreateArrayBufferAllocator(), uv_default_loop(), platform.get());
+    {
+        v8::Locker locker(isolate);
+        v8::Isolate::Scope isolateScope(isolate);
+        v8::HandleScope handleScope(isolate);
+
+        v8::Local<v8::Context> ctx = v8::Context::New(isolate);
+        v8::Context::Scope contextScope(ctx);
+
+        std::printf("js-module benchmarks (%u iterations):\n", iterations);
+        BenchTimers(isolate, ctx);
+        BenchSerialization(isolate, ctx);
+    }
+
+    platform->UnregisterIsolate(isolate);
+    isolate->Dispose();
+    v8::V8::Dispose();
+    v8::V8::DisposePlatform();
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "stdafx.h"
+
+#include "CNodePlatform.h"
+
+#include <chrono>
+
+static int64_t GetTimeMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Counts the task as completed once it ran, optionally adding its run time
+class CountedTask : public v8::Task
+{
+    std::unique_ptr<v8::Task> task;
+    std::atomic<uint64_t>& completed;
+    std::atomic<uint64_t>* time;
+
+public:
+    CountedTask(std::unique_ptr<v8::Task> task, std::atomic<uint64_t>& completed, std::atomic<uint64_t>* time)
+        : task(std::move(task)), completed(completed), time(time)
+    {
+    }
+
+    void Run() override
+    {
+        int64_t start = time ? GetTimeMicroseconds() : 0;
+        task->Run();
+        if(time) *time += GetTimeMicroseconds() - start;
+        completed++;
+    }
+};
+
+class TimedJobTask : public v8::JobTask
+{
+    std::unique_ptr<v8::JobTask> task;
+    std::atomic<uint64_t>& time;
+
+public:
+    TimedJobTask(std::unique_ptr<v8::JobTask> task, std::atomic<uint64_t>& time) : task(std::move(task)), time(time) {}
+
+    void Run(v8::JobDelegate* delegate) override
+    {
+        int64_t start = GetTimeMicroseconds();
+        task->Run(delegate);
+        time += GetTimeMicroseconds() - start;
+    }
+    size_t GetMaxConcurrency(size_t workerCount) const override
+    {
+        return task->GetMaxConcurrency(workerCount);
+    }
+};
+
+// Foreground task runner of an isolate, the tasks still run on the runner of the default platform
+class CNodePlatform::TaskRunner : public v8::TaskRunner
+{
+    std::shared_ptr<v8::TaskRunner> runner;
+    Stats& stats;
+
+    std::unique_ptr<v8::Task> Wrap(std::unique_ptr<v8::Task> task)
+    {
+        stats.foregroundQueued++;
+        return std::make_unique<CountedTask>(std::move(task), stats.foregroundCompleted, nullptr);
+    }
+
+public:
+    TaskRunner(std::shared_ptr<v8::TaskRunner> runner, Stats& stats) : runner(std::move(runner)), stats(stats) {}
+
+    void PostTask(std::unique_ptr<v8::Task> task) override
+    {
+        runner->PostTask(Wrap(std::move(task)));
+    }
+    void PostNonNestableTask(std::unique_ptr<v8::Task> task) override
+    {
+        runner->PostNonNestableTask(Wrap(std::move(task)));
+    }
+    void PostDelayedTask(std::unique_ptr<v8::Task> task, double delayInSeconds) override
+    {
+        runner->PostDelayedTask(Wrap(std::move(task)), delayInSeconds);
+    }
+    void PostNonNestableDelayedTask(std::unique_ptr<v8::Task> task, double delayInSeconds) override
+    {
+        runner->PostNonNestableDelayedTask(Wrap(std::move(task)), delayInSeconds);
+    }
+    void PostIdleTask(std::unique_ptr<v8::IdleTask> task) override
+    {
+        runner->PostIdleTask(std::move(task));
+    }
+    bool IdleTasksEnabled() override
+    {
+        return runner->IdleTasksEnabled();
+    }
+    bool NonNestableTasksEnabled() const override
+    {
+        return runner->NonNestableTasksEnabled();
+    }
+    bool NonNestableDelayedTasksEnabled() const override
+    {
+        return runner->NonNestableDelayedTasksEnabled();
+    }
+};
+
+CNodePlatform::CNodePlatform(int _threadCount) : platform(node::MultiIsolatePlatform::Create(_threadCount)), threadCount(_threadCount) {}
+
+std::unique_ptr<v8::Task> CNodePlatform::WrapBackgroundTask(std::unique_ptr<v8::Task> task)
+{
+    stats.backgroundQueued++;
+    return std::make_unique<CountedTask>(std::move(task), stats.backgroundCompleted, &stats.backgroundTime);
+}
+
+void CNodePlatform::PrintStats()
+{
+    auto average = [](uint64_t time, uint64_t count) { return count == 0 ? 0.0 : time / 1000.0 / count; };
+
+    Log::Info << "================ Platform info =================" << Log::Endl;
+    Log::Info << "Worker threads: " << threadCount << Log::Endl;
+    Log::Info << "Foreground tasks: " << stats.foregroundCompleted << " completed, " << stats.foregroundQueued - stats.foregroundCompleted << " pending" << Log::Endl;
+    Log::Info << "Background tasks: " << stats.backgroundCompleted << " completed, " << stats.backgroundQueued - stats.backgroundCompleted << " pending, avg "
+              << average(stats.backgroundTime, stats.backgroundCompleted) << "ms" << Log::Endl;
+    Log::Info << "Background jobs: " << stats.jobsTime / 1000.0 << "ms total" << Log::Endl;
+    Log::Info << "DrainTasks: " << stats.drainCount << " calls, avg " << average(stats.drainTime, stats.drainCount) << "ms" << Log::Endl;
+    Log::Info << "======================================================" << Log::Endl;
+}
+
+bool CNodePlatform::FlushForegroundTasks(v8::Isolate* isolate)
+{
+    return platform->FlushForegroundTasks(isolate);
+}
+
+void CNodePlatform::DrainTasks(v8::Isolate* isolate)
+{
+    int64_t start = GetTimeMicroseconds();
+    platform->DrainTasks(isolate);
+    stats.drainTime += GetTimeMicroseconds() - start;
+    stats.drainCount++;
+}
+
+void CNodePlatform::RegisterIsolate(v8::Isolate* isolate, struct uv_loop_s* loop)
+{
+    platform->RegisterIsolate(isolate, loop);
+}
+
+void CNodePlatform::RegisterIsolate(v8::Isolate* isolate, node::IsolatePlatformDelegate* delegate)
+{
+    platform->RegisterIsolate(isolate, delegate);
+}
+
+void CNodePlatform::UnregisterIsolate(v8::Isolate* isolate)
+{
+    {
+        std::scoped_lock lock(taskRunnersMutex);
+        taskRunners.erase(isolate);
+    }
+    platform->UnregisterIsolate(isolate);
+}
+
+void CNodePlatform::AddIsolateFinishedCallback(v8::Isolate* isolate, void (*callback)(void*), void* data)
+{
+    platform->AddIsolateFinishedCallback(isolate, callback, data);
+}
+
+v8::PageAllocator* CNodePlatform::GetPageAllocator()
+{
+    return platform->GetPageAllocator();
+}
+
+v8::ZoneBackingAllocator* CNodePlatform::GetZoneBackingAllocator()
+{
+    return platform->GetZoneBackingAllocator();
+}
+
+void CNodePlatform::OnCriticalMemoryPressure()
+{
+    platform->OnCriticalMemoryPressure();
+}
+
+bool CNodePlatform::OnCriticalMemoryPressure(size_t length)
+{
+    return platform->OnCriticalMemoryPressure(length);
+}
+
+int CNodePlatform::NumberOfWorkerThreads()
+{
+    return platform->NumberOfWorkerThreads();
+}
+
+std::shared_ptr<v8::TaskRunner> CNodePlatform::GetForegroundTaskRunner(v8::Isolate* isolate)
+{
+    std::scoped_lock lock(taskRunnersMutex);
+    std::shared_ptr<TaskRunner>& runner = taskRunners[isolate];
+    if(!runner) runner = std::make_shared<TaskRunner>(platform->GetForegroundTaskRunner(isolate), stats);
+    return runner;
+}
+
+void CNodePlatform::CallOnWorkerThread(std::unique_ptr<v8::Task> task)
+{
+    platform->CallOnWorkerThread(WrapBackgroundTask(std::move(task)));
+}
+
+void CNodePlatform::CallBlockingTaskOnWorkerThread(std::unique_ptr<v8::Task> task)
+{
+    platform->CallBlockingTaskOnWorkerThread(WrapBackgroundTask(std::move(task)));
+}
+
+void CNodePlatform::CallLowPriorityTaskOnWorkerThread(std::unique_ptr<v8::Task> task)
+{
+    platform->CallLowPriorityTaskOnWorkerThread(WrapBackgroundTask(std::move(task)));
+}
+
+void CNodePlatform::CallDelayedOnWorkerThread(std::unique_ptr<v8::Task> task, double delayInSeconds)
+{
+    platform->CallDelayedOnWorkerThread(WrapBackgroundTask(std::move(task)), delayInSeconds);
+}
+
+bool CNodePlatform::IdleTasksEnabled(v8::Isolate* isolate)
+{
+    return platform->IdleTasksEnabled(isolate);
+}
+
+std::unique_ptr<v8::JobHandle> CNodePlatform::PostJob(v8::TaskPriority priority, std::unique_ptr<v8::JobTask> jobTask)
+{
+    // The default platform posts the workers of the job to itself, so the job is timed as a whole
+    return platform->PostJob(priority, std::make_unique<TimedJobTask>(std::move(jobTask), stats.jobsTime));
+}
+
+double CNodePlatform::MonotonicallyIncreasingTime()
+{
+    return platform->MonotonicallyIncreasingTime();
+}
+
+double CNodePlatform::CurrentClockTimeMillis()
+{
+    return platform->CurrentClockTimeMillis();
+}
+
+v8::Platform::StackTracePrinter CNodePlatform::GetStackTracePrinter()
+{
+    return platform->GetStackTracePrinter();
+}
+
+v8::TracingController* CNodePlatform::GetTracingController()
+{
+    return platform->GetTracingController();
+}
+
+void CNodePlatform::DumpWithoutCrashing()
+{
+    platform->DumpWithoutCrashing();
+}
+
+v8::HighAllocationThroughputObserver* CNodePlatform::GetHighAllocationThroughputObserver()
+{
+    return platform->GetHighAllocationThroughputObserver();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "node.h"
+#include "v8-platform.h"
+
+// Node platform that forwards everything to the default one, counting the tasks that pass through it.
+// Times are in microseconds, like the other node metrics.
+class CNodePlatform : public node::MultiIsolatePlatform
+{
+public:
+    struct Stats
+    {
+        std::atomic<uint64_t> foregroundQueued = 0;
+        std::atomic<uint64_t> foregroundCompleted = 0;
+        std::atomic<uint64_t> backgroundQueued = 0;
+        std::atomic<uint64_t> backgroundCompleted = 0;
+        std::atomic<uint64_t> backgroundTime = 0;
+        // Jobs are the parallel work of V8, mostly concurrent marking, sweeping and compilation
+        std::atomic<uint64_t> jobsTime = 0;
+        std::atomic<uint64_t> drainCount = 0;
+        std::atomic<uint64_t> drainTime = 0;
+    };
+
+private:
+    class TaskRunner;
+
+    std::unique_ptr<node::MultiIsolatePlatform> platform;
+    int threadCount;
+    Stats stats;
+
+    std::mutex taskRunnersMutex;
+    std::unordered_map<v8::Isolate*, std::shared_ptr<TaskRunner>> taskRunners;
+
+    std::unique_ptr<v8::Task> WrapBackgroundTask(std::unique_ptr<v8::Task> task);
+
+public:
+    explicit CNodePlatform(int threadCount);
+
+    const Stats& GetStats() const
+    {
+        return stats;
+    }
+    int GetThreadCount() const
+    {
+        return threadCount;
+    }
+    void PrintStats();
+
+    // node::MultiIsolatePlatform
+    bool FlushForegroundTasks(v8::Isolate* isolate) override;
+    void DrainTasks(v8::Isolate* isolate) override;
+    void RegisterIsolate(v8::Isolate* isolate, struct uv_loop_s* loop) override;
+    void RegisterIsolate(v8::Isolate* isolate, node::IsolatePlatformDelegate* delegate) override;
+    void UnregisterIsolate(v8::Isolate* isolate) override;
+    void AddIsolateFinishedCallback(v8::Isolate* isolate, void (*callback)(void*), void* data) override;
+
+    // v8::Platform
+    v8::PageAllocator* GetPageAllocator() override;
+    v8::ZoneBackingAllocator* GetZoneBackingAllocator() override;
+    void OnCriticalMemoryPressure() override;
+    bool OnCriticalMemoryPressure(size_t length) override;
+    int NumberOfWorkerThreads() override;
+    std::shared_ptr<v8::TaskRunner> GetForegroundTaskRunner(v8::Isolate* isolate) override;
+    void CallOnWorkerThread(std::unique_ptr<v8::Task> task) override;
+    void CallBlockingTaskOnWorkerThread(std::unique_ptr<v8::Task> task) override;
+    void CallLowPriorityTaskOnWorkerThread(std::unique_ptr<v8::Task> task) override;
+    void CallDelayedOnWorkerThread(std::unique_ptr<v8::Task> task, double delayInSeconds) override;
+    bool IdleTasksEnabled(v8::Isolate* isolate) override;
+    std::unique_ptr<v8::JobHandle> PostJob(v8::TaskPriority priority, std::unique_ptr<v8::JobTask> jobTask) override;
+    double MonotonicallyIncreasingTime() override;
+    double CurrentClockTimeMillis() override;
+    StackTracePrinter GetStackTracePrinter() override;
+    v8::TracingController* GetTracingController() override;
+    void DumpWithoutCrashing() override;
+    v8::HighAllocationThroughputObserver* GetHighAllocationThroughputObserver() override;
+};
@@ -4,8 +4,11 @@
 #include "CNodeScriptRuntime.h"
 #include "V8Module.h"
 #include "V8Helpers.h"
+#include "V8Class.h"
 
-#include "JSBindings.h"
+#include "V8CodeCache.h"
+
+#include <unordered_set>
 
 static void ResourceLoaded(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
@@ -43,6 +46,31 @@ CNodeResourceImpl::CNodeResourceImpl(CNodeScriptRuntime* _runtime, v8::Isolate*
     context.Reset(isolate, _context);
 }
 
+// Data of the wrapper of an exported function, owned by the wrapper
+struct DirectExport
+{
+    CNodeResourceImpl* resource;
+    // The resource is only valid as long as it still has the context the function was exported from
+    v8::Global<v8::Context> context;
+    v8::Global<v8::Function> function;
+    // Weak, the data is deleted once the wrapper is collected
+    v8::Global<v8::Function> wrapper;
+};
+
+// Wrappers that were not collected yet, so their handles can be released when the exporting resource stops
+static std::unordered_set<DirectExport*> liveDirectExports;
+
+static void ReleaseDirectExports(CNodeResourceImpl* resource)
+{
+    for(DirectExport* directExport : liveDirectExports)
+    {
+        if(directExport->resource != resource) continue;
+        directExport->resource = nullptr;
+        directExport->context.Reset();
+        directExport->function.Reset();
+    }
+}
+
 bool CNodeResourceImpl::Start()
 {
     v8::Locker locker(isolate);
@@ -52,7 +80,7 @@ bool CNodeResourceImpl::Start()
     v8::Context::Scope scope(_context);
 
     _context->Global()->Set(_context, V8Helpers::JSValue("__resourceLoaded"), v8::Function::New(_context, &ResourceLoaded).ToLocalChecked());
-    _context->Global()->Set(_context, V8Helpers::JSValue("__internal_bindings_code"), V8Helpers::JSValue(JSBindings::GetBindingsCode()));
+    _context->Global()->Set(_context, V8Helpers::JSValue("__internal_load_bindings"), v8::Function::New(_context, &V8CodeCache::LoadBindings).ToLocalChecked());
 
     V8ResourceImpl::Start();
     V8ResourceImpl::SetupScriptGlobals();
@@ -94,6 +122,7 @@ bool CNodeResourceImpl::Stop()
     {
         v8::Context::Scope scope(GetContext());
         DispatchStopEvent();
+        FlushClientEvents();
 
         node::EmitAsyncDestroy(isolate, asyncContext);
         asyncResource.Reset();
@@ -116,19 +145,137 @@ bool CNodeResourceImpl::Stop()
 
     vehiclePassengers.clear();
 
+    // CPersistent doesn't reset on destruction
+    for(auto& [model, info] : vehicleModelInfos) info.Reset();
+    vehicleModelInfos.clear();
+    for(auto& [model, info] : pedModelInfos) info.Reset();
+    pedModelInfos.clear();
+
     rpcHandlers.clear();
     remoteRPCHandlers.clear();
     awaitableRPCHandlers.clear();
 
+    exportedFunctions.clear();
+    directExports.clear();
+    ReleaseDirectExports(this);
+    // The wrappers other resources created for this one belong to the context that is destroyed now
+    for(CNodeResourceImpl* other : runtime->GetResources()) other->directExports.erase(resource);
+
     return true;
 }
 
+// Values passed between the contexts of two resources. Primitives are shared by all contexts of the isolate,
+// base objects are mapped to the entity of the other resource and everything else is copied like a MValue.
+extern V8Class v8BaseObject;
+static v8::Local<v8::Value> CloneToContext(v8::Local<v8::Value> val, v8::Local<v8::Context> from, v8::Local<v8::Context> to)
+{
+    if(val->IsUndefined() || val->IsNull() || val->IsBoolean() || val->IsNumber() || val->IsString()) return val;
+
+    // Brand check, other objects with internal fields are no V8Entity
+    v8::Isolate* isolate = from->GetIsolate();
+    if(val->IsObject() && v8BaseObject.GetTemplate(isolate)->HasInstance(val))
+    {
+        V8Entity* entity = V8Entity::Get(val);
+        return entity ? V8ResourceImpl::Get(to)->GetBaseObjectOrNull(entity->GetHandle()) : v8::Null(isolate).As<v8::Value>();
+    }
+
+    alt::MValue mvalue;
+    {
+        v8::Context::Scope scope(from);
+        mvalue = V8Helpers::V8ToMValue(val);
+    }
+    v8::Context::Scope scope(to);
+    return V8Helpers::MValueToV8(mvalue);
+}
+
+static void CallDirectExport(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    DirectExport* directExport = static_cast<DirectExport*>(info.Data().As<v8::External>()->Value());
+
+    CNodeResourceImpl* resource = directExport->resource;
+    V8_CHECK(resource, "Tried to call exported function of invalid resource");
+    v8::Local<v8::Context> resourceCtx = directExport->context.Get(isolate);
+    V8_CHECK(CNodeScriptRuntime::Instance().HasResource(resource) && resource->GetContext() == resourceCtx && resource->IsEnvStarted(),
+             "Tried to call exported function of invalid resource");
+
+    std::vector<v8::Local<v8::Value>> args;
+    args.reserve(info.Length());
+    for(int i = 0; i < info.Length(); i++) args.push_back(CloneToContext(info[i], ctx, resourceCtx));
+
+    v8::Local<v8::Value> result = v8::Undefined(isolate);
+    {
+        v8::Context::Scope scope(resourceCtx);
+        node::CallbackScope callbackScope(isolate, resource->GetAsyncResource(), resource->GetAsyncContext());
+
+        V8Helpers::TryCatch(
+          [&]
+          {
+              v8::MaybeLocal<v8::Value> retn = V8Helpers::CallFunctionWithTimeout(directExport->function.Get(isolate), resourceCtx, args, "Exported function");
+              if(retn.IsEmpty()) return false;
+
+              result = CloneToContext(retn.ToLocalChecked(), resourceCtx, ctx);
+              return true;
+          });
+    }
+
+    V8_RETURN(result);
+}
+
+v8::Local<v8::Value> CNodeResourceImpl::GetDirectExports(v8::Local<v8::Context> callerContext)
+{
+    // The exports are only converted once per importing resource, a restarted resource has a new context
+    DirectExports& cache = directExports[V8ResourceImpl::GetResource(callerContext)];
+    if(!cache.context.IsEmpty() && cache.context.Get(isolate) == callerContext) return cache.exports.Get(isolate);
+
+    v8::Local<v8::Value> exports = V8Helpers::MValueToV8(resource->GetExports());
+    if(!exportedFunctions.empty() && exports->IsObject())
+    {
+        v8::Local<v8::Object> exportsObj = exports.As<v8::Object>();
+        for(auto& [name, function] : exportedFunctions)
+        {
+            DirectExport* directExport = new DirectExport{ this, v8::Global<v8::Context>(isolate, GetContext()), v8::Global<v8::Function>(isolate, function.Get(isolate)) };
+            liveDirectExports.insert(directExport);
+
+            v8::Local<v8::Function> wrapper = v8::Function::New(callerContext, &CallDirectExport, v8::External::New(isolate, directExport)).ToLocalChecked();
+            directExport->wrapper.Reset(isolate, wrapper);
+            directExport->wrapper.SetWeak(
+              directExport,
+              [](const v8::WeakCallbackInfo<DirectExport>& info)
+              {
+                  liveDirectExports.erase(info.GetParameter());
+                  delete info.GetParameter();
+              },
+              v8::WeakCallbackType::kParameter);
+
+            exportsObj->Set(callerContext, V8Helpers::JSValue(name), wrapper);
+        }
+    }
+
+    cache.context.Reset(isolate, callerContext);
+    cache.exports.Reset(isolate, exports);
+    return exports;
+}
+
 void CNodeResourceImpl::Started(v8::Local<v8::Value> _exports)
 {
     if(!_exports->IsNullOrUndefined())
     {
         alt::MValueDict exports = std::dynamic_pointer_cast<alt::IMValueDict>(V8Helpers::V8ToMValue(_exports));
         resource->SetExports(exports);
+
+        v8::Local<v8::Context> ctx = GetContext();
+        v8::Local<v8::Array> keys;
+        if(_exports->IsObject() && _exports.As<v8::Object>()->GetOwnPropertyNames(ctx).ToLocal(&keys))
+        {
+            for(uint32_t i = 0; i < keys->Length(); i++)
+            {
+                v8::Local<v8::Value> key = keys->Get(ctx, i).ToLocalChecked();
+                v8::Local<v8::Value> value;
+                if(!_exports.As<v8::Object>()->Get(ctx, key).ToLocal(&value) || !value->IsFunction()) continue;
+                exportedFunctions[*v8::String::Utf8Value(isolate, key)].Reset(isolate, value.As<v8::Function>());
+            }
+        }
         envStarted = true;
     }
     else
@@ -179,17 +326,17 @@ void CNodeResourceImpl::OnEvent(const alt::CEvent* e)
         auto evType = e->GetType();
         if(evType == alt::CEvent::Type::CLIENT_SCRIPT_EVENT || evType == alt::CEvent::Type::SERVER_SCRIPT_EVENT)
         {
-            std::vector<V8Helpers::EventCallback*> callbacks;
+            V8Helpers::EventCallbackSpan callbacks;
             const char* eventName;
 
             if(evType == alt::CEvent::Type::SERVER_SCRIPT_EVENT)
             {
-                callbacks = std::move(GetGenericHandlers(true));
+                callbacks = GetGenericHandlers(true);
                 eventName = static_cast<const alt::CServerScriptEvent*>(e)->GetName().c_str();
             }
             else if(evType == alt::CEvent::Type::CLIENT_SCRIPT_EVENT)
             {
-                callbacks = std::move(GetGenericHandlers(false));
+                callbacks = GetGenericHandlers(false);
                 eventName = static_cast<const alt::CClientScriptEvent*>(e)->GetName().c_str();
             }
 
@@ -204,7 +351,7 @@ void CNodeResourceImpl::OnEvent(const alt::CEvent* e)
         }
     }
 
-    std::vector<V8Helpers::EventCallback*> callbacks = handler->GetCallbacks(this, e);
+    V8Helpers::EventCallbackSpan callbacks = handler->GetCallbacks(this, e);
     if(callbacks.size() > 0)
     {
         std::vector<v8::Local<v8::Value>> args = handler->GetArgs(this, e);
@@ -280,7 +427,7 @@ void CNodeResourceImpl::HandleClientRpcEvent(alt::CScriptRPCEvent* ev)
     args.push_back(GetBaseObjectOrNull(ev->GetTarget()));
     V8Helpers::MValueArgsToV8(ev->GetArgs(), args);
 
-    auto result = V8Helpers::CallFunctionWithTimeout(handler->second.Get(isolate), context, args);
+    auto result = V8Helpers::CallFunctionWithTimeout(handler->second.Get(isolate), context, args, "RPC " + ev->GetName());
 
     v8::Local<v8::Value> returnValue;
     if (!result.IsEmpty())
@@ -359,6 +506,59 @@ void CNodeResourceImpl::OnTick()
 
     uv_run(uvLoop, UV_RUN_NOWAIT);
     V8ResourceImpl::OnTick();
+
+    FlushClientEvents();
+}
+
+void CNodeResourceImpl::OnRemoveBaseObject(alt::IBaseObject* handle)
+{
+    V8ResourceImpl::OnRemoveBaseObject(handle);
+
+    // Dropped after the handlers ran, they can still queue events for the player (e.g. in playerDisconnect)
+    if(handle->GetType() == alt::IBaseObject::Type::PLAYER) clientEventBatches.erase(dynamic_cast<alt::IPlayer*>(handle));
+}
+
+void CNodeResourceImpl::QueueClientEvent(alt::IPlayer* player, const std::string& name, const alt::MValueArgs& args, bool coalesce)
+{
+    ClientEventBatch& batch = clientEventBatches[player];
+    if(coalesce)
+    {
+        auto [it, inserted] = batch.coalesced.insert({ name, batch.events.size() });
+        if(!inserted)
+        {
+            batch.events[it->second].second = args;
+            return;
+        }
+    }
+    batch.events.emplace_back(name, args);
+}
+
+void CNodeResourceImpl::FlushClientEvents()
+{
+    if(clientEventBatches.empty()) return;
+
+    alt::ICore& core = alt::ICore::Instance();
+    for(auto& [player, batch] : clientEventBatches)
+    {
+        if(batch.events.size() == 1)
+        {
+            core.TriggerClientEvent(player, batch.events[0].first, batch.events[0].second);
+            continue;
+        }
+
+        alt::MValueList events = core.CreateMValueList(batch.events.size() * 2);
+        for(size_t i = 0; i < batch.events.size(); i++)
+        {
+            auto& [name, args] = batch.events[i];
+            alt::MValueList eventArgs = core.CreateMValueList(args.size());
+            for(size_t j = 0; j < args.size(); j++) eventArgs->Set(j, args[j]);
+
+            events->Set(i * 2, core.CreateMValueString(name));
+            events->Set(i * 2 + 1, eventArgs);
+        }
+        core.TriggerClientEvent(player, V8Helpers::CLIENT_EVENT_BATCH, { events });
+    }
+    clientEventBatches.clear();
 }
 
 bool CNodeResourceImpl::MakeClient(alt::IResource::CreationInfo* info, std::vector<std::string>)
@@ -30,10 +30,18 @@ public:
     void HandleClientRpcAnswerEvent(const alt::CScriptRPCAnswerEvent* ev);
 
     void OnTick() override;
+    void OnRemoveBaseObject(alt::IBaseObject* handle) override;
+
+    // Queues the event to be sent together with the other events queued for the player in this tick,
+    // when coalesced a previously queued event with the same name is replaced
+    void QueueClientEvent(alt::IPlayer* player, const std::string& name, const alt::MValueArgs& args, bool coalesce);
+    void FlushClientEvents();
 
     bool MakeClient(alt::IResource::CreationInfo* info, std::vector<std::string>) override;
 
     void Started(v8::Local<v8::Value> exports);
+    // Exports as seen from the context of another JS resource, exported functions are called directly instead of through MValues
+    v8::Local<v8::Value> GetDirectExports(v8::Local<v8::Context> callerContext);
     node::Environment* GetEnv()
     {
         return env;
@@ -51,8 +59,40 @@ public:
         return envStarted;
     }
 
+    // Key = Model hash, Value = Frozen model info object
+    using ModelInfoCache = std::unordered_map<uint32_t, V8Helpers::CPersistent<v8::Object>>;
+    ModelInfoCache& GetVehicleModelInfoCache()
+    {
+        return vehicleModelInfos;
+    }
+    ModelInfoCache& GetPedModelInfoCache()
+    {
+        return pedModelInfos;
+    }
+
 private:
+    struct ClientEventBatch
+    {
+        std::vector<std::pair<std::string, alt::MValueArgs>> events;
+        // Index of the queued coalesced events by name
+        std::unordered_map<std::string, size_t> coalesced;
+    };
+
+    // Exports converted into the context of an importing resource, with wrappers of the exported functions
+    struct DirectExports
+    {
+        v8::Global<v8::Context> context;
+        v8::Global<v8::Value> exports;
+    };
+
     CNodeScriptRuntime* runtime;
+    std::unordered_map<alt::IPlayer*, ClientEventBatch> clientEventBatches;
+    ModelInfoCache vehicleModelInfos;
+    ModelInfoCache pedModelInfos;
+    // Key = Export name
+    std::unordered_map<std::string, v8::Global<v8::Function>> exportedFunctions;
+    // Key = Importing resource
+    std::unordered_map<alt::IResource*, DirectExports> directExports;
 
     bool envStarted = false;
     bool startError = false;
@@ -2,6 +2,12 @@
 
 #include "CNodeScriptRuntime.h"
 #include "CProfiler.h"
+#include "CSpatialIndex.h"
+#include "V8ResourceMetrics.h"
+#include "V8Watchdog.h"
+
+#include <algorithm>
+#include <cstdlib>
 
 bool CNodeScriptRuntime::Init()
 {
@@ -19,11 +25,12 @@ bool CNodeScriptRuntime::Init()
         return false;
     }
 
-    platform = node::MultiIsolatePlatform::Create(4);
+    platform = std::make_unique<CNodePlatform>(platformThreads);
     v8::V8::InitializePlatform(platform.get());
     v8::V8::Initialize();
 
     isolate = node::NewIsolate(node::CreateArrayBufferAllocator(), uv_default_loop(), platform.get());
+    V8ResourceMetrics::RegisterGCCallbacks(isolate);
 
     // IsWorker data slot
     isolate->SetData(v8::Isolate::GetNumberOfDataSlots() - 1, new bool(false));
@@ -59,6 +66,9 @@ void CNodeScriptRuntime::OnTick()
     platform->DrainTasks(isolate);
 
     UpdateMetrics();
+
+    // Entities may have moved since the last tick
+    CSpatialIndex::Instance().Invalidate();
 }
 
 void CNodeScriptRuntime::OnDispose()
@@ -78,7 +88,11 @@ void CNodeScriptRuntime::OnDispose()
     v8::V8::ShutdownPlatform();
     */
 
+    V8Watchdog::Instance().Shutdown();
+
     if(CProfiler::Instance().IsEnabled()) CProfiler::Instance().Dump("./");
+
+    Log::Shutdown();
 }
 
 std::vector<std::string> CNodeScriptRuntime::GetNodeArgs()
@@ -134,6 +148,33 @@ void CNodeScriptRuntime::ProcessConfigOptions()
         CProfiler::Instance().SetIsEnabled(true);
         CProfiler::Instance().SetLogsEnabled(profiler["logs"]->AsBool(false));
     }
+
+    Config::Value::ValuePtr logLevel = moduleConfig["logLevel"];
+    if(!logLevel->IsNone() && !Log::SetLevel(logLevel->AsString())) Log::Warning << "Invalid log level: " << logLevel->AsString() << Log::Endl;
+
+    // Scripts paused by the debugger would be terminated, so the budget is disabled by default when the inspector is used
+    Config::Value::ValuePtr executionTimeout = moduleConfig["executionTimeout"];
+    if(!executionTimeout->IsNone()) V8Watchdog::Instance().SetDefaultTimeout((uint32_t)executionTimeout->AsNumber(0));
+    else if(!moduleConfig["inspector"]->IsNone())
+        V8Watchdog::Instance().SetDefaultTimeout(0);
+
+    Config::Value::ValuePtr zeroCopyByteArrays = moduleConfig["zeroCopyByteArrays"];
+    V8Helpers::SetZeroCopyByteArrays(zeroCopyByteArrays->AsBool(false));
+
+    Config::Value::ValuePtr platformThreadsValue = moduleConfig["platformThreads"];
+    if(!platformThreadsValue->IsNone()) platformThreads = std::max((int)platformThreadsValue->AsNumber(platformThreads), 1);
+
+    // libuv reads the size when the threadpool is used for the first time, so it has to be set before node is initialized
+    Config::Value::ValuePtr uvThreadpoolSize = moduleConfig["uvThreadpoolSize"];
+    if(!uvThreadpoolSize->IsNone())
+    {
+        std::string size = std::to_string(std::max((int)uvThreadpoolSize->AsNumber(4), 1));
+#ifdef _WIN32
+        _putenv_s("UV_THREADPOOL_SIZE", size.c_str());
+#else
+        setenv("UV_THREADPOOL_SIZE", size.c_str(), 1);
+#endif
+    }
 }
 
 void CNodeScriptRuntime::RegisterMetrics()
@@ -147,6 +188,16 @@ void CNodeScriptRuntime::RegisterMetrics()
     registerMetric(Metric::PHYSICAL_LIMIT, "node_physical_limit", alt::Metric::Type::METRIC_TYPE_GAUGE);
     registerMetric(Metric::GLOBAL_HANDLES_SIZE, "node_global_handles_size", alt::Metric::Type::METRIC_TYPE_GAUGE);
     registerMetric(Metric::GLOBAL_HANDLES_LIMIT, "node_global_handles_limit", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::GC_COUNT, "node_gc_count", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::GC_PAUSE_TIME, "node_gc_pause_time", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::FOREGROUND_TASKS_QUEUED, "node_foreground_tasks_queued", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::FOREGROUND_TASKS_COMPLETED, "node_foreground_tasks_completed", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::BACKGROUND_TASKS_QUEUED, "node_background_tasks_queued", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::BACKGROUND_TASKS_COMPLETED, "node_background_tasks_completed", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::BACKGROUND_TASKS_TIME, "node_background_tasks_time", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::BACKGROUND_JOBS_TIME, "node_background_jobs_time", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::DRAIN_TASKS_COUNT, "node_drain_tasks_count", alt::Metric::Type::METRIC_TYPE_GAUGE);
+    registerMetric(Metric::DRAIN_TASKS_TIME, "node_drain_tasks_time", alt::Metric::Type::METRIC_TYPE_GAUGE);
 }
 
 void CNodeScriptRuntime::UpdateMetrics()
@@ -163,4 +214,48 @@ void CNodeScriptRuntime::UpdateMetrics()
     updateMetric(Metric::PHYSICAL_LIMIT, heapStats.total_available_size());
     updateMetric(Metric::GLOBAL_HANDLES_SIZE, heapStats.used_global_handles_size());
     updateMetric(Metric::GLOBAL_HANDLES_LIMIT, heapStats.total_global_handles_size());
+
+    // Times are in microseconds
+    const V8ResourceMetrics::GCStats& gc = V8ResourceMetrics::GetGCStats();
+    updateMetric(Metric::GC_COUNT, gc.scavenge.GetCount() + gc.markSweep.GetCount() + gc.other.GetCount());
+    updateMetric(Metric::GC_PAUSE_TIME, gc.scavenge.GetTotal() + gc.markSweep.GetTotal() + gc.other.GetTotal());
+
+    const CNodePlatform::Stats& platformStats = platform->GetStats();
+    updateMetric(Metric::FOREGROUND_TASKS_QUEUED, platformStats.foregroundQueued);
+    updateMetric(Metric::FOREGROUND_TASKS_COMPLETED, platformStats.foregroundCompleted);
+    updateMetric(Metric::BACKGROUND_TASKS_QUEUED, platformStats.backgroundQueued);
+    updateMetric(Metric::BACKGROUND_TASKS_COMPLETED, platformStats.backgroundCompleted);
+    updateMetric(Metric::BACKGROUND_TASKS_TIME, platformStats.backgroundTime);
+    updateMetric(Metric::BACKGROUND_JOBS_TIME, platformStats.jobsTime);
+    updateMetric(Metric::DRAIN_TASKS_COUNT, platformStats.drainCount);
+    updateMetric(Metric::DRAIN_TASKS_TIME, platformStats.drainTime);
+
+    for(CNodeResourceImpl* resource : resources)
+    {
+        const std::string& name = resource->GetResource()->GetName();
+        auto it = resourceMetrics.find(name);
+        if(it == resourceMetrics.end())
+        {
+            auto registerResourceMetric = [&](const char* metric) { return core.RegisterMetric(("node_resource_" + name + "_" + metric).c_str(), alt::Metric::Type::METRIC_TYPE_GAUGE); };
+            it = resourceMetrics
+                   .insert({ name,
+                             { registerResourceMetric("events_count"),
+                               registerResourceMetric("events_time"),
+                               registerResourceMetric("timers_count"),
+                               registerResourceMetric("timers_time"),
+                               registerResourceMetric("timers_lateness"),
+                               registerResourceMetric("raw_serialized_bytes"),
+                               registerResourceMetric("raw_deserialized_bytes") } })
+                   .first;
+        }
+
+        V8ResourceMetrics& resourceMetric = resource->GetMetrics();
+        it->second.eventsCount->SetValue(resourceMetric.GetEventsCount());
+        it->second.eventsTime->SetValue(resourceMetric.GetEventsTime());
+        it->second.timersCount->SetValue(resourceMetric.GetTimerExecution().GetCount());
+        it->second.timersTime->SetValue(resourceMetric.GetTimerExecution().GetTotal());
+        it->second.timersLateness->SetValue(resourceMetric.GetTimerLateness().GetTotal());
+        it->second.rawSerializedBytes->SetValue(resourceMetric.GetRawSerializedBytes());
+        it->second.rawDeserializedBytes->SetValue(resourceMetric.GetRawDeserializedBytes());
+    }
 }
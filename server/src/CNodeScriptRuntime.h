@@ -4,15 +4,19 @@
 
 #include "V8Helpers.h"
 #include "CNodeResourceImpl.h"
+#include "CNodePlatform.h"
 
 #include "IRuntimeEventHandler.h"
 
 class CNodeScriptRuntime : public alt::IScriptRuntime, public IRuntimeEventHandler
 {
     v8::Isolate* isolate;
-    std::unique_ptr<node::MultiIsolatePlatform> platform;
+    std::unique_ptr<CNodePlatform> platform;
     std::unordered_set<CNodeResourceImpl*> resources;
 
+    // Worker threads of the node platform, used by V8 for concurrent GC and compilation
+    int platformThreads = 4;
+
     enum class Metric : uint8_t
     {
         HEAP_SIZE,
@@ -21,12 +25,35 @@ class CNodeScriptRuntime : public alt::IScriptRuntime, public IRuntimeEventHandl
         PHYSICAL_LIMIT,
         GLOBAL_HANDLES_SIZE,
         GLOBAL_HANDLES_LIMIT,
+        GC_COUNT,
+        GC_PAUSE_TIME,
+        FOREGROUND_TASKS_QUEUED,
+        FOREGROUND_TASKS_COMPLETED,
+        BACKGROUND_TASKS_QUEUED,
+        BACKGROUND_TASKS_COMPLETED,
+        BACKGROUND_TASKS_TIME,
+        BACKGROUND_JOBS_TIME,
+        DRAIN_TASKS_COUNT,
+        DRAIN_TASKS_TIME,
 
         SIZE
     };
 
     std::unordered_map<Metric, alt::Metric*> metrics;
 
+    // Registered when a resource is seen for the first time, kept after it was stopped so a restart reuses them
+    struct ResourceMetrics
+    {
+        alt::Metric* eventsCount;
+        alt::Metric* eventsTime;
+        alt::Metric* timersCount;
+        alt::Metric* timersTime;
+        alt::Metric* timersLateness;
+        alt::Metric* rawSerializedBytes;
+        alt::Metric* rawDeserializedBytes;
+    };
+    std::unordered_map<std::string, ResourceMetrics> resourceMetrics;
+
     void RegisterMetrics();
     void UpdateMetrics();
 
@@ -45,6 +72,8 @@ public:
     {
         auto res = static_cast<CNodeResourceImpl*>(impl);
         resources.erase(res);
+        // Queued log lines still point to the resource
+        Log::Flush();
         delete res;
     }
 
@@ -54,7 +83,7 @@ public:
     std::vector<std::string> GetNodeArgs();
     void ProcessConfigOptions();
 
-    node::MultiIsolatePlatform* GetPlatform() const
+    CNodePlatform* GetPlatform() const
     {
         return platform.get();
     }
@@ -63,6 +92,10 @@ public:
     {
         return resources;
     }
+    bool HasResource(CNodeResourceImpl* resource) const
+    {
+        return resources.count(resource) != 0;
+    }
 
     static CNodeScriptRuntime& Instance()
     {
@@ -264,6 +264,55 @@ static void EmitAllClientsUnreliable(const v8::FunctionCallbackInfo<v8::Value>&
     ICore::Instance().TriggerClientEventUnreliableForAll(eventName, args);
 }
 
+static void QueueClientEvent(const v8::FunctionCallbackInfo<v8::Value>& info, bool coalesce)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN_MIN(2);
+
+    V8_ARG_TO_STRING(2, eventName);
+
+    MValueArgs mvArgs;
+    mvArgs.reserve(info.Length() - 2);
+
+    for(int i = 2; i < info.Length(); ++i) mvArgs.emplace_back(V8Helpers::V8ToMValue(info[i], false));
+
+    CNodeResourceImpl* nodeResource = static_cast<CNodeResourceImpl*>(resource);
+    if(info[0]->IsArray())
+    {
+        v8::Local<v8::Array> arr = info[0].As<v8::Array>();
+        for(uint32_t i = 0; i < arr->Length(); ++i)
+        {
+            v8::Local<v8::Value> ply;
+            bool toLocalSuccess = arr->Get(ctx, i).ToLocal(&ply);
+            V8_CHECK_NORETN(toLocalSuccess, "Invalid player in players array");
+            if(!toLocalSuccess) continue;
+            V8Entity* v8Player = V8Entity::Get(ply);
+
+            bool isPlayerType = v8Player && v8Player->GetHandle() && v8Player->GetHandle()->GetType() == alt::IBaseObject::Type::PLAYER;
+            V8_CHECK_NORETN(isPlayerType, "player inside array expected");
+            if(!isPlayerType) continue;
+            nodeResource->QueueClientEvent(dynamic_cast<alt::IPlayer*>(v8Player->GetHandle()), eventName, mvArgs, coalesce);
+        }
+    }
+    else
+    {
+        V8Entity* v8Player = V8Entity::Get(info[0]);
+        V8_CHECK(v8Player && v8Player->GetHandle() && v8Player->GetHandle()->GetType() == alt::IBaseObject::Type::PLAYER, "player or player array expected");
+
+        nodeResource->QueueClientEvent(dynamic_cast<alt::IPlayer*>(v8Player->GetHandle()), eventName, mvArgs, coalesce);
+    }
+}
+
+static void EmitClientBatched(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    QueueClientEvent(info, false);
+}
+
+static void EmitClientCoalesced(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    QueueClientEvent(info, true);
+}
+
 static void OnRpc(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
     V8_GET_ISOLATE_CONTEXT();
@@ -393,7 +442,7 @@ static void HasExtra(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(1);
     V8_ARG_TO_UINT(1, extra);
-    uint32_t hash = info.Data().As<v8::Uint32>()->Value();
+    V8_GET_THIS_INTERNAL_FIELD_UINT32(1, hash);
 
     const alt::VehicleModelInfo& modelInfo = alt::ICore::Instance().GetVehicleModelByHash(hash);
     V8_RETURN_BOOLEAN(modelInfo.DoesExtraExist(extra));
@@ -403,21 +452,59 @@ static void HasDefaultExtra(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT();
     V8_CHECK_ARGS_LEN(1);
     V8_ARG_TO_UINT(1, extra);
-    uint32_t hash = info.Data().As<v8::Uint32>()->Value();
+    V8_GET_THIS_INTERNAL_FIELD_UINT32(1, hash);
 
     const alt::VehicleModelInfo& modelInfo = alt::ICore::Instance().GetVehicleModelByHash(hash);
     V8_RETURN_BOOLEAN(modelInfo.DoesExtraDefault(extra));
 }
-static void GetVehicleModelByHash(const v8::FunctionCallbackInfo<v8::Value>& info)
+
+extern V8Class v8VehicleModelInfo("VehicleModelInfo",
+                                  [](v8::Local<v8::FunctionTemplate> tpl)
+                                  {
+                                      v8::Isolate* isolate = v8::Isolate::GetCurrent();
+
+                                      // Internal field 1 is the model hash
+                                      tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+                                      V8Helpers::SetMethod(isolate, tpl, "hasExtra", &HasExtra);
+                                      V8Helpers::SetMethod(isolate, tpl, "hasDefaultExtra", &HasDefaultExtra);
+                                  });
+
+template<typename T>
+static v8::Local<v8::Array> CreateBonesArray(v8::Local<v8::Context> ctx, const T& bones)
 {
-    V8_GET_ISOLATE_CONTEXT();
-    V8_CHECK_ARGS_LEN(1);
+    v8::Isolate* isolate = ctx->GetIsolate();
 
-    V8_ARG_TO_UINT(1, hash);
+    size_t boneSize = std::size(bones);
+    v8::Local<v8::Array> boneArr = v8::Array::New(isolate, boneSize);
+    for(size_t i = 0; i < boneSize; i++)
+    {
+        V8_NEW_OBJECT(boneObj);
+        boneObj->Set(ctx, V8Helpers::JSValue("id"), V8Helpers::JSValue(bones[i].id));
+        boneObj->Set(ctx, V8Helpers::JSValue("index"), V8Helpers::JSValue(bones[i].index));
+        boneObj->Set(ctx, V8Helpers::JSValue("name"), V8Helpers::JSValue(bones[i].name));
+        boneObj->SetIntegrityLevel(ctx, v8::IntegrityLevel::kFrozen);
+        boneArr->Set(ctx, i, boneObj);
+    }
+    boneArr->SetIntegrityLevel(ctx, v8::IntegrityLevel::kFrozen);
+    return boneArr;
+}
+
+// Model infos are static, so every resource creates the frozen object once per model and returns it on every lookup
+static v8::Local<v8::Object> GetVehicleModelInfo(CNodeResourceImpl* resource, uint32_t hash)
+{
+    v8::Isolate* isolate = resource->GetIsolate();
+    v8::Local<v8::Context> ctx = resource->GetContext();
+
+    auto& cache = resource->GetVehicleModelInfoCache();
+    auto it = cache.find(hash);
+    if(it != cache.end()) return it->second.Get(isolate);
 
     const alt::VehicleModelInfo& modelInfo = alt::ICore::Instance().GetVehicleModelByHash(hash);
-    V8_NEW_OBJECT(infoObj);
+    v8::Local<v8::Object> infoObj = v8VehicleModelInfo.CreateInstance(ctx);
+    infoObj->SetInternalField(0, v8::Uint32::NewFromUnsigned(isolate, hash));
 
+    infoObj->Set(ctx, V8Helpers::JSValue("hash"), V8Helpers::JSValue(hash));
     infoObj->Set(ctx, V8Helpers::JSValue("title"), V8Helpers::JSValue(modelInfo.title));
     infoObj->Set(ctx, V8Helpers::JSValue("type"), V8Helpers::JSValue((int)modelInfo.modelType));
     infoObj->Set(ctx, V8Helpers::JSValue("wheelsCount"), V8Helpers::JSValue(modelInfo.wheelsCount));
@@ -436,27 +523,42 @@ static void GetVehicleModelByHash(const v8::FunctionCallbackInfo<v8::Value>& inf
     {
         modkitsArr->Set(ctx, i, V8Helpers::JSValue(modelInfo.modkits[i] != 0xFFFF));
     }
+    modkitsArr->SetIntegrityLevel(ctx, v8::IntegrityLevel::kFrozen);
     infoObj->Set(ctx, V8Helpers::JSValue("availableModkits"), modkitsArr);
 
-    infoObj->Set(ctx, V8Helpers::JSValue("hasExtra"), v8::Function::New(ctx, &HasExtra, v8::Uint32::NewFromUnsigned(isolate, hash)).ToLocalChecked());
-    infoObj->Set(ctx, V8Helpers::JSValue("hasDefaultExtra"), v8::Function::New(ctx, &HasDefaultExtra, v8::Uint32::NewFromUnsigned(isolate, hash)).ToLocalChecked());
-
-    size_t boneSize = std::size(modelInfo.bones);
-    v8::Local<v8::Array> boneArr = v8::Array::New(isolate, boneSize);
-    for(size_t i = 0; i < boneSize; i++)
-    {
-        V8_NEW_OBJECT(boneObj);
-        boneObj->Set(ctx, V8Helpers::JSValue("id"), V8Helpers::JSValue(modelInfo.bones[i].id));
-        boneObj->Set(ctx, V8Helpers::JSValue("index"), V8Helpers::JSValue(modelInfo.bones[i].index));
-        boneObj->Set(ctx, V8Helpers::JSValue("name"), V8Helpers::JSValue(modelInfo.bones[i].name));
-        boneArr->Set(ctx, i, boneObj);
-    }
-    infoObj->Set(ctx, V8Helpers::JSValue("bones"), boneArr);
+    infoObj->Set(ctx, V8Helpers::JSValue("bones"), CreateBonesArray(ctx, modelInfo.bones));
 
     infoObj->Set(ctx, V8Helpers::JSValue("canAttachCars"), V8Helpers::JSValue(modelInfo.canAttachCars));
     infoObj->Set(ctx, V8Helpers::JSValue("handlingNameHash"), V8Helpers::JSValue(modelInfo.handlingNameHash));
 
-    V8_RETURN(infoObj);
+    infoObj->SetIntegrityLevel(ctx, v8::IntegrityLevel::kFrozen);
+    cache[hash].Reset(isolate, infoObj);
+    return infoObj;
+}
+
+static void GetVehicleModelByHash(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN(1);
+
+    V8_ARG_TO_UINT(1, hash);
+
+    V8_RETURN(GetVehicleModelInfo(static_cast<CNodeResourceImpl*>(resource), hash));
+}
+
+static void GetAllVehicleModels(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+
+    CNodeResourceImpl* nodeResource = static_cast<CNodeResourceImpl*>(resource);
+    std::vector<uint32_t> models = alt::ICore::Instance().GetLoadedVehicleModels();
+    v8::Local<v8::Array> arr = v8::Array::New(isolate, models.size());
+    for(size_t i = 0; i < models.size(); i++)
+    {
+        arr->Set(ctx, i, GetVehicleModelInfo(nodeResource, models[i]));
+    }
+
+    V8_RETURN(arr);
 }
 
 static void GetServerConfig(const v8::FunctionCallbackInfo<v8::Value>& info)
@@ -471,11 +573,19 @@ static void GetServerConfig(const v8::FunctionCallbackInfo<v8::Value>& info)
 
 static void GetPedModelByHash(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
-    V8_GET_ISOLATE_CONTEXT();
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
     V8_CHECK_ARGS_LEN(1);
 
     V8_ARG_TO_UINT(1, hash);
 
+    auto& cache = static_cast<CNodeResourceImpl*>(resource)->GetPedModelInfoCache();
+    auto it = cache.find(hash);
+    if(it != cache.end())
+    {
+        V8_RETURN(it->second.Get(isolate));
+        return;
+    }
+
     const alt::PedModelInfo& modelInfo = alt::ICore::Instance().GetPedModelByHash(hash);
     V8_NEW_OBJECT(infoObj);
 
@@ -485,19 +595,10 @@ static void GetPedModelByHash(const v8::FunctionCallbackInfo<v8::Value>& info)
     infoObj->Set(ctx, V8Helpers::JSValue("dlcName"), V8Helpers::JSValue(modelInfo.dlcName));
     infoObj->Set(ctx, V8Helpers::JSValue("defaultUnarmedWeapon"), V8Helpers::JSValue(modelInfo.defaultUnarmedWeapon));
     infoObj->Set(ctx, V8Helpers::JSValue("movementClipSet"), V8Helpers::JSValue(modelInfo.movementClipSet));
+    infoObj->Set(ctx, V8Helpers::JSValue("bones"), CreateBonesArray(ctx, modelInfo.bones));
 
-    size_t boneSize = std::size(modelInfo.bones);
-    v8::Local<v8::Array> boneArr = v8::Array::New(isolate, boneSize);
-    for(size_t i = 0; i < boneSize; i++)
-    {
-        V8_NEW_OBJECT(boneObj);
-        boneObj->Set(ctx, V8Helpers::JSValue("id"), V8Helpers::JSValue(modelInfo.bones[i].id));
-        boneObj->Set(ctx, V8Helpers::JSValue("index"), V8Helpers::JSValue(modelInfo.bones[i].index));
-        boneObj->Set(ctx, V8Helpers::JSValue("name"), V8Helpers::JSValue(modelInfo.bones[i].name));
-        boneArr->Set(ctx, i, boneObj);
-    }
-    infoObj->Set(ctx, V8Helpers::JSValue("bones"), boneArr);
-
+    infoObj->SetIntegrityLevel(ctx, v8::IntegrityLevel::kFrozen);
+    cache[hash].Reset(isolate, infoObj);
     V8_RETURN(infoObj);
 }
 
@@ -871,6 +972,8 @@ extern V8Module
             V8Helpers::RegisterFunc(exports, "emitAllClientsRaw", &EmitAllClientsRaw);
             V8Helpers::RegisterFunc(exports, "emitClientUnreliable", &EmitClientUnreliable);
             V8Helpers::RegisterFunc(exports, "emitAllClientsUnreliable", &EmitAllClientsUnreliable);
+            V8Helpers::RegisterFunc(exports, "emitClientBatched", &EmitClientBatched);
+            V8Helpers::RegisterFunc(exports, "emitClientCoalesced", &EmitClientCoalesced);
 
             V8Helpers::RegisterFunc(exports, "onRpc", &OnRpc);
             V8Helpers::RegisterFunc(exports, "offRpc", &OffRpc);
@@ -885,6 +988,7 @@ extern V8Module
 
             V8Helpers::RegisterFunc(exports, "getVehicleModelInfoByHash", &GetVehicleModelByHash);
             V8Helpers::RegisterFunc(exports, "getLoadedVehicleModels", &GetLoadedVehicleModels);
+            V8Helpers::RegisterFunc(exports, "getAllVehicleModels", &GetAllVehicleModels);
             V8Helpers::RegisterFunc(exports, "getPedModelInfoByHash", &GetPedModelByHash);
             V8Helpers::RegisterFunc(exports, "getWeaponModelInfoByHash", &GetWeaponModelByHash);
             V8Helpers::RegisterFunc(exports, "getAmmoHashForWeaponHash", &GetAmmoHashForWeaponHash);
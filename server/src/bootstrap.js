@@ -26,7 +26,7 @@ const url = require("url");
 
     // Load the global bindings code
     const bindingsGlobal = {};
-    new Function("alt", "__global", __internal_bindings_code)(alt, bindingsGlobal);
+    __internal_load_bindings(alt, bindingsGlobal);
     __setLogFunction(bindingsGlobal.genericLog);
 
     const extraBootstrapFile = __getExtraBootstrapFile();
@@ -0,0 +1,225 @@
+#include "CProfiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <ctime>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+
+#include "Log.h"
+
+uint32_t CProfiler::GetBucket(int64_t duration)
+{
+    if(duration < (1 << BUCKET_SUB_BITS)) return duration < 0 ? 0 : (uint32_t)duration;
+
+    uint32_t msb = std::bit_width((uint64_t)duration) - 1;
+    uint32_t sub = (duration >> (msb - BUCKET_SUB_BITS)) & ((1 << BUCKET_SUB_BITS) - 1);
+    return ((msb - BUCKET_SUB_BITS + 1) << BUCKET_SUB_BITS) | sub;
+}
+
+int64_t CProfiler::GetBucketValue(uint32_t bucket)
+{
+    if(bucket < (1 << BUCKET_SUB_BITS)) return bucket;
+
+    uint32_t msb = (bucket >> BUCKET_SUB_BITS) + BUCKET_SUB_BITS - 1;
+    uint32_t sub = bucket & ((1 << BUCKET_SUB_BITS) - 1);
+    int64_t width = int64_t(1) << (msb - BUCKET_SUB_BITS);
+    // Middle of the bucket range
+    return (int64_t((1 << BUCKET_SUB_BITS) | sub) << (msb - BUCKET_SUB_BITS)) + width / 2;
+}
+
+uint32_t CProfiler::RegisterName(const std::string& name)
+{
+    CProfiler& profiler = Instance();
+    std::scoped_lock lock(profiler.mutex);
+
+    uint32_t count = profiler.namesCount.load(std::memory_order_relaxed);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        if(profiler.names[i] == name) return i;
+    }
+
+    if(count == MAX_NAMES)
+    {
+        Log::Warning << "~w~[Profiler] ~w~Too many sample names registered, ignoring samples of ~lc~" << name << Log::Endl;
+        return INVALID_ID;
+    }
+
+    profiler.names[count] = name;
+    profiler.namesCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+CProfiler::ThreadBuffer* CProfiler::GetThreadBuffer()
+{
+    // Gives the buffer back when the thread exits
+    struct Owner
+    {
+        ThreadBuffer* buffer = nullptr;
+        ~Owner()
+        {
+            if(buffer) buffer->inUse.store(false, std::memory_order_release);
+        }
+    };
+    thread_local Owner owner;
+    if(owner.buffer) return owner.buffer;
+
+    std::scoped_lock lock(mutex);
+    for(auto& thread : threads)
+    {
+        if(thread->inUse.load(std::memory_order_acquire)) continue;
+        thread->inUse.store(true, std::memory_order_relaxed);
+        owner.buffer = thread.get();
+        return owner.buffer;
+    }
+    owner.buffer = threads.emplace_back(std::make_unique<ThreadBuffer>((uint32_t)threads.size() + 1)).get();
+    return owner.buffer;
+}
+
+void CProfiler::AddSample(uint32_t id, int64_t start, int64_t end, bool skipLog)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    int64_t duration = end - start;
+
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    Event& event = buffer->events[head & RING_MASK];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.id.store(id, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(duration, std::memory_order_relaxed);
+    event.sequence.store(head + 1, std::memory_order_release);
+    buffer->head.store(head + 1, std::memory_order_release);
+
+    // The buffer is only written by this thread, so there is no need for atomic read-modify-write operations
+    Stats& stats = buffer->stats[id];
+    stats.count.store(stats.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    stats.total.store(stats.total.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+    if(duration < stats.min.load(std::memory_order_relaxed)) stats.min.store(duration, std::memory_order_relaxed);
+    if(duration > stats.max.load(std::memory_order_relaxed)) stats.max.store(duration, std::memory_order_relaxed);
+    std::atomic<uint32_t>& bucket = stats.buckets[GetBucket(duration)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if(skipLog || !AreLogsEnabled()) return;
+    float ms = duration / 1000000.f;
+    std::string color = ms > 50 ? "~lr~" : ms > 20 ? "~ly~" : "~lg~";
+    Log::Colored << "~c~[Profiler] ~lc~" << names[id] << "~w~ took: " << color << ms << "ms" << Log::Endl;
+}
+
+static void WriteJSONString(std::ostream& stream, const std::string& str)
+{
+    stream << '"';
+    for(char c : str)
+    {
+        if(c == '"' || c == '\\') stream << '\\' << c;
+        else if((unsigned char)c < 0x20)
+            stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        else
+            stream << c;
+    }
+    stream << '"';
+}
+
+void CProfiler::Dump(const std::string& path)
+{
+    if(!IsEnabled()) return;
+
+    int64_t t = std::time(nullptr);
+    std::tm time;
+#if defined(__unix__)
+    localtime_r(&t, &time);
+#elif defined(_MSC_VER)
+    localtime_s(&time, &t);
+#else
+    time = *std::localtime(&t);
+#endif
+    std::ostringstream stream;
+    stream << std::put_time(&time, "%d-%m-%Y %H-%M-%S");
+    std::filesystem::path filePath = path / std::filesystem::path(stream.str() + ".trace.json");
+
+    std::ofstream file(filePath.string());
+    if(!file.good())
+    {
+        Log::Error << "~w~[Profiler] ~w~Failed to dump samples" << Log::Endl;
+        file.close();
+        return;
+    }
+
+    std::scoped_lock lock(mutex);
+    uint32_t count = namesCount.load(std::memory_order_acquire);
+
+    // Timestamps and durations are written in microseconds, as expected by the trace event format
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for(auto& thread : threads)
+    {
+        if(!first) file << ',';
+        first = false;
+        file << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadId << ",\"args\":{\"name\":\"Thread " << thread->threadId << "\"}}";
+
+        uint64_t head = thread->head.load(std::memory_order_acquire);
+        for(uint64_t i = head > RING_SIZE ? head - RING_SIZE : 0; i < head; i++)
+        {
+            // Samples that are overwritten while reading them are skipped
+            const Event& event = thread->events[i & RING_MASK];
+            if(event.sequence.load(std::memory_order_acquire) != i + 1) continue;
+            uint32_t id = event.id.load(std::memory_order_relaxed);
+            int64_t start = event.start.load(std::memory_order_relaxed);
+            int64_t duration = event.duration.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(event.sequence.load(std::memory_order_relaxed) != i + 1 || id >= count) continue;
+
+            file << ",\n{\"name\":";
+            WriteJSONString(file, names[id]);
+            file << ",\"cat\":\"js-module\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->threadId << ",\"ts\":" << start / 1000.0 << ",\"dur\":" << duration / 1000.0 << '}';
+        }
+    }
+    file << "\n],\n\"stats\":[";
+
+    // Merge the stats of all threads
+    first = true;
+    for(uint32_t id = 0; id < count; id++)
+    {
+        uint64_t samples = 0;
+        int64_t total = 0;
+        int64_t min = std::numeric_limits<int64_t>::max();
+        int64_t max = 0;
+        std::array<uint64_t, BUCKET_COUNT> buckets{};
+        for(auto& thread : threads)
+        {
+            Stats& stats = thread->stats[id];
+            samples += stats.count.load(std::memory_order_relaxed);
+            total += stats.total.load(std::memory_order_relaxed);
+            min = std::min(min, stats.min.load(std::memory_order_relaxed));
+            max = std::max(max, stats.max.load(std::memory_order_relaxed));
+            for(uint32_t i = 0; i < BUCKET_COUNT; i++) buckets[i] += stats.buckets[i].load(std::memory_order_relaxed);
+        }
+        if(samples == 0) continue;
+
+        auto percentile = [&](double p)
+        {
+            uint64_t target = (uint64_t)(samples * p);
+            uint64_t seen = 0;
+            for(uint32_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                seen += buckets[i];
+                if(seen > target) return std::clamp(GetBucketValue(i), min, max);
+            }
+            return max;
+        };
+
+        if(!first) file << ',';
+        first = false;
+        file << "\n{\"name\":";
+        WriteJSONString(file, names[id]);
+        file << ",\"count\":" << samples << ",\"min\":" << min / 1000.0 << ",\"max\":" << max / 1000.0 << ",\"avg\":" << (double)total / samples / 1000.0
+             << ",\"p50\":" << percentile(0.5) / 1000.0 << ",\"p99\":" << percentile(0.99) / 1000.0 << '}';
+    }
+    file << "\n]}\n";
+
+    file.close();
+    Log::Colored << "~c~[Profiler] ~w~Dumped samples to ~lc~" << filePath.string() << Log::Endl;
+}
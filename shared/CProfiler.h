@@ -1,93 +1,95 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <ctime>
-#include <sstream>
-#include <fstream>
-#include <iomanip>
-#include <filesystem>
-
-#include "Log.h"
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
+// Samples are recorded into fixed-size per-thread buffers, so taking a sample never allocates or locks.
+// Sample names have to be registered once with RegisterName, the returned id is used for the samples.
 class CProfiler
 {
-    using Duration = std::chrono::high_resolution_clock::duration;
-    using TimePoint = std::chrono::high_resolution_clock::time_point;
-
-    bool enabled = false;
-    bool logsEnabled = true;
-    std::unordered_multimap<std::string, Duration> samples;
-    std::unordered_map<std::string, TimePoint> runningSamples;
-
-    void StartSample(const std::string& name)
+public:
+    static constexpr uint32_t INVALID_ID = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t MAX_NAMES = 128;
+
+    // Log-linear histogram, every power of two is split into 4 buckets
+    static constexpr uint32_t BUCKET_SUB_BITS = 2;
+    static constexpr uint32_t BUCKET_COUNT = 64 << BUCKET_SUB_BITS;
+
+    static uint32_t GetBucket(int64_t duration);
+    // Returns the middle of the value range of the bucket
+    static int64_t GetBucketValue(uint32_t bucket);
+
+private:
+    // Every thread keeps the last 32768 samples for the trace export, older samples are overwritten
+    static constexpr uint32_t RING_BITS = 15;
+    static constexpr uint32_t RING_SIZE = 1 << RING_BITS;
+    static constexpr uint32_t RING_MASK = RING_SIZE - 1;
+
+    // Written by the owning thread while the dump might read it, so every field is atomic.
+    // The sequence is the ring index + 1 of the sample, it is 0 while the sample is being written.
+    struct Event
     {
-        if(!enabled) return;
-        runningSamples.insert({ name, std::chrono::high_resolution_clock::now() });
-    }
-    void EndSample(const std::string& name, bool skipLog)
+        std::atomic<uint64_t> sequence = 0;
+        std::atomic<uint32_t> id = 0;
+        std::atomic<int64_t> start = 0;
+        std::atomic<int64_t> duration = 0;
+    };
+
+    // Only written by the owning thread, the relaxed atomics only make reading them from the dump safe
+    struct Stats
     {
-        if(!enabled) return;
-        auto it = runningSamples.find(name);
-        if(it == runningSamples.end()) return;
-        Duration duration = std::chrono::high_resolution_clock::now() - it->second;
-        samples.insert({ name, duration });
-        runningSamples.erase(it);
-
-        if(skipLog || !logsEnabled) return;
-        float ms = duration.count() / 1000000.f;
-        std::string color = ms > 50 ? "~lr~" : ms > 20 ? "~ly~" : "~lg~";
-        Log::Colored << "~c~[Profiler] ~lc~" << name << "~w~ took: " << color << ms << "ms" << Log::Endl;
-    }
+        std::atomic<uint64_t> count = 0;
+        std::atomic<int64_t> total = 0;
+        std::atomic<int64_t> min = std::numeric_limits<int64_t>::max();
+        std::atomic<int64_t> max = 0;
+        std::array<std::atomic<uint32_t>, BUCKET_COUNT> buckets{};
+    };
 
-public:
-    void Dump(const std::string& path)
+    struct ThreadBuffer
     {
-        if(!enabled) return;
-
-        int64_t t = std::time(nullptr);
-        std::tm time;
-#if defined(__unix__)
-        localtime_r(&t, &time);
-#elif defined(_MSC_VER)
-        localtime_s(&time, &t);
-#else
-        time = *std::localtime(&t);
-#endif
-        std::ostringstream stream;
-        stream << std::put_time(&time, "%d-%m-%Y %H-%M-%S");
-        std::filesystem::path filePath = path / std::filesystem::path(stream.str() + ".samples");
-
-        std::ofstream file(filePath.string());
-        if(!file.good())
-        {
-            Log::Error << "~w~[Profiler] ~w~Failed to dump samples" << Log::Endl;
-            file.close();
-            return;
-        }
+        uint32_t threadId;
+        // Cleared when the thread exits, the buffer is then reused by the next thread that samples
+        std::atomic<bool> inUse = true;
+        std::atomic<uint64_t> head = 0;
+        std::unique_ptr<Event[]> events = std::make_unique<Event[]>(RING_SIZE);
+        std::unique_ptr<Stats[]> stats = std::make_unique<Stats[]>(MAX_NAMES);
+
+        ThreadBuffer(uint32_t _threadId) : threadId(_threadId) {}
+    };
 
-        for(auto it = samples.begin(), end = samples.end(); it != end; it = samples.equal_range(it->first).second)
-        {
-            file << it->first << ' ';
-            auto items = samples.equal_range(it->first);
-            auto lastItem = std::prev(items.second);
-            for(auto i = items.first; i != items.second; ++i)
-            {
-                file << i->second.count();
-                if(i != lastItem) file << ',';
-            }
-
-            file << '\n';
-        }
+    std::atomic<bool> enabled = false;
+    std::atomic<bool> logsEnabled = true;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    // Only locked when registering names or threads, never while sampling
+    std::mutex mutex;
+    std::array<std::string, MAX_NAMES> names;
+    std::atomic<uint32_t> namesCount = 0;
+    // Buffers are kept after their thread has exited, so the samples can still be dumped.
+    // There are never more buffers than threads that sampled at the same time.
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
 
-        file.close();
-        Log::Colored << "~c~[Profiler] ~w~Dumped samples to ~lc~" << filePath.string() << Log::Endl;
+    ThreadBuffer* GetThreadBuffer();
+    void AddSample(uint32_t id, int64_t start, int64_t end, bool skipLog);
+
+    int64_t Now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
     }
 
+public:
+    // Writes a Chrome trace event file (chrome://tracing, ui.perfetto.dev), that also contains the aggregated stats of every sample
+    void Dump(const std::string& path);
+
     bool IsEnabled() const
     {
-        return enabled;
+        return enabled.load(std::memory_order_relaxed);
     }
     void SetIsEnabled(bool state)
     {
@@ -95,7 +97,7 @@ public:
     }
     bool AreLogsEnabled() const
     {
-        return logsEnabled;
+        return logsEnabled.load(std::memory_order_relaxed);
     }
     void SetLogsEnabled(bool state)
     {
@@ -108,19 +110,26 @@ public:
         return instance;
     }
 
+    // Returns the id for the sample name, registering the same name again returns the same id
+    static uint32_t RegisterName(const std::string& name);
+
     class Sample
     {
-        std::string name;
+        uint32_t id;
         bool skipLog;
+        int64_t start = -1;
 
     public:
-        Sample(const std::string& _name, bool _skipLog = false) : name(_name), skipLog(_skipLog)
+        Sample(uint32_t _id, bool _skipLog = false) : id(_id), skipLog(_skipLog)
         {
-            Instance().StartSample(name);
+            CProfiler& profiler = Instance();
+            if(profiler.IsEnabled() && id != INVALID_ID) start = profiler.Now();
         }
         ~Sample()
         {
-            Instance().EndSample(name, skipLog);
+            if(start == -1) return;
+            CProfiler& profiler = Instance();
+            profiler.AddSample(id, start, profiler.Now(), skipLog);
         }
     };
 };
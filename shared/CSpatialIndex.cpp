@@ -0,0 +1,247 @@
+#include "CSpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cpp-sdk/ICore.h"
+
+// Types that are added to the grid, all of them are world objects
+static const alt::IBaseObject::Type indexedTypes[] = {
+    alt::IBaseObject::Type::PLAYER,        alt::IBaseObject::Type::VEHICLE,    alt::IBaseObject::Type::PED,       alt::IBaseObject::Type::OBJECT,
+    alt::IBaseObject::Type::VIRTUAL_ENTITY,
+#ifdef ALT_CLIENT_API
+    alt::IBaseObject::Type::LOCAL_VEHICLE, alt::IBaseObject::Type::LOCAL_PED, alt::IBaseObject::Type::LOCAL_OBJECT,
+#endif
+};
+
+bool CSpatialIndex::IsIndexed(alt::IBaseObject::Type type)
+{
+    return std::find(std::begin(indexedTypes), std::end(indexedTypes), type) != std::end(indexedTypes);
+}
+
+void CSpatialIndex::Release()
+{
+    if(users == 0) return;
+    // Without a started resource no remove events arrive, so the stored pointers can't be trusted anymore
+    if(--users == 0) Clear();
+}
+
+void CSpatialIndex::Clear()
+{
+    items.clear();
+    dimensions.clear();
+    built = false;
+    stale = false;
+}
+
+void CSpatialIndex::Build()
+{
+    Clear();
+    built = true;
+
+    alt::ICore& core = alt::ICore::Instance();
+    for(alt::IBaseObject::Type type : indexedTypes)
+    {
+        for(alt::IBaseObject* object : core.GetBaseObjects(type)) Add(object);
+    }
+}
+
+void CSpatialIndex::Refresh()
+{
+    stale = false;
+    for(auto& [object, item] : items) Relocate(item);
+}
+
+void CSpatialIndex::Insert(Item& item)
+{
+    Cell& cell = dimensions[item.dimension][item.cell];
+    item.cellIndex = (uint32_t)cell.size();
+    cell.push_back(&item);
+}
+
+void CSpatialIndex::Erase(Item& item)
+{
+    auto dimension = dimensions.find(item.dimension);
+    if(dimension == dimensions.end()) return;
+    auto cell = dimension->second.find(item.cell);
+    if(cell == dimension->second.end()) return;
+
+    Cell& cellItems = cell->second;
+    Item* last = cellItems.back();
+    cellItems[item.cellIndex] = last;
+    last->cellIndex = item.cellIndex;
+    cellItems.pop_back();
+
+    if(cellItems.empty())
+    {
+        dimension->second.erase(cell);
+        if(dimension->second.empty()) dimensions.erase(dimension);
+    }
+}
+
+void CSpatialIndex::Relocate(Item& item)
+{
+    int32_t dimension = item.object->GetDimension();
+    uint64_t cell = GetCellKey(item.object->GetPosition());
+    if(dimension == item.dimension && cell == item.cell) return;
+
+    Erase(item);
+    item.dimension = dimension;
+    item.cell = cell;
+    Insert(item);
+}
+
+void CSpatialIndex::Add(alt::IBaseObject* baseObject)
+{
+    if(!built || !IsIndexed(baseObject->GetType())) return;
+    // Every resource forwards the same base object events
+    if(items.count(baseObject) != 0) return;
+
+    alt::IWorldObject* object = dynamic_cast<alt::IWorldObject*>(baseObject);
+    if(!object) return;
+
+    Item& item = items.insert({ baseObject, Item{ object, baseObject->GetType(), object->GetDimension(), GetCellKey(object->GetPosition()), 0 } }).first->second;
+    Insert(item);
+}
+
+void CSpatialIndex::Remove(alt::IBaseObject* object)
+{
+    if(!built) return;
+    auto it = items.find(object);
+    if(it == items.end()) return;
+
+    Erase(it->second);
+    items.erase(it);
+}
+
+void CSpatialIndex::Update(alt::IBaseObject* object)
+{
+    if(!built) return;
+    auto it = items.find(object);
+    if(it != items.end()) Relocate(it->second);
+}
+
+template<typename Func>
+void CSpatialIndex::ForEachInArea(const alt::Vector3f& min, const alt::Vector3f& max, std::optional<int32_t> dimension, Func&& fn)
+{
+    if(!built) Build();
+    else if(stale) Refresh();
+
+    auto forEachInDimension = [&](const Dimension& dim)
+    {
+        // Areas that cover more cells than are used are faster to check cell by cell
+        double cellsX = std::floor(max[0] / CELL_SIZE) - std::floor(min[0] / CELL_SIZE) + 1;
+        double cellsY = std::floor(max[1] / CELL_SIZE) - std::floor(min[1] / CELL_SIZE) + 1;
+        if(!std::isfinite(cellsX * cellsY) || cellsX * cellsY >= (double)dim.size())
+        {
+            for(auto& [key, cell] : dim)
+            {
+                for(Item* item : cell) fn(*item);
+            }
+            return;
+        }
+
+        for(int32_t x = GetCellCoord(min[0]); x <= GetCellCoord(max[0]); x++)
+        {
+            for(int32_t y = GetCellCoord(min[1]); y <= GetCellCoord(max[1]); y++)
+            {
+                auto it = dim.find(GetCellKey(x, y));
+                if(it == dim.end()) continue;
+                for(Item* item : it->second) fn(*item);
+            }
+        }
+    };
+
+    if(dimension)
+    {
+        auto it = dimensions.find(*dimension);
+        if(it != dimensions.end()) forEachInDimension(it->second);
+    }
+    else
+    {
+        for(auto& [id, dim] : dimensions) forEachInDimension(dim);
+    }
+}
+
+static float GetDistanceSquared(const alt::Vector3f& a, const alt::Vector3f& b)
+{
+    float dx = a[0] - b[0];
+    float dy = a[1] - b[1];
+    float dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void CSpatialIndex::GetInRange(const alt::Vector3f& pos, float range, std::optional<int32_t> dimension, uint64_t allowedTypes, Result& result)
+{
+    alt::Vector3f min{ pos[0] - range, pos[1] - range, pos[2] - range };
+    alt::Vector3f max{ pos[0] + range, pos[1] + range, pos[2] + range };
+    float rangeSquared = range * range;
+
+    ForEachInArea(min,
+                  max,
+                  dimension,
+                  [&](const Item& item)
+                  {
+                      if(!IsAllowed(allowedTypes, item.type)) return;
+                      if(dimension && item.object->GetDimension() != *dimension) return;
+                      if(GetDistanceSquared(pos, item.object->GetPosition()) <= rangeSquared) result.push_back(item.object);
+                  });
+}
+
+void CSpatialIndex::GetInBox(const alt::Vector3f& min, const alt::Vector3f& max, std::optional<int32_t> dimension, uint64_t allowedTypes, Result& result)
+{
+    ForEachInArea(min,
+                  max,
+                  dimension,
+                  [&](const Item& item)
+                  {
+                      if(!IsAllowed(allowedTypes, item.type)) return;
+                      if(dimension && item.object->GetDimension() != *dimension) return;
+                      alt::Vector3f pos = item.object->GetPosition();
+                      for(int i = 0; i < 3; i++)
+                      {
+                          if(pos[i] < min[i] || pos[i] > max[i]) return;
+                      }
+                      result.push_back(item.object);
+                  });
+}
+
+void CSpatialIndex::GetClosest(const alt::Vector3f& pos, float range, std::optional<int32_t> dimension, uint32_t limit, uint64_t allowedTypes, Result& result)
+{
+    alt::Vector3f min{ pos[0] - range, pos[1] - range, pos[2] - range };
+    alt::Vector3f max{ pos[0] + range, pos[1] + range, pos[2] + range };
+    float rangeSquared = range * range;
+
+    std::vector<std::pair<float, alt::IWorldObject*>> found;
+    ForEachInArea(min,
+                  max,
+                  dimension,
+                  [&](const Item& item)
+                  {
+                      if(!IsAllowed(allowedTypes, item.type)) return;
+                      if(dimension && item.object->GetDimension() != *dimension) return;
+                      float distance = GetDistanceSquared(pos, item.object->GetPosition());
+                      if(distance <= rangeSquared) found.push_back({ distance, item.object });
+                  });
+
+    auto end = found.begin() + std::min<size_t>(limit, found.size());
+    std::partial_sort(found.begin(), end, found.end(), [](auto& a, auto& b) { return a.first < b.first; });
+    for(auto it = found.begin(); it != end; ++it) result.push_back(it->second);
+}
+
+void CSpatialIndex::GetInDimension(int32_t dimension, uint64_t allowedTypes, Result& result)
+{
+    if(!built) Build();
+    else if(stale) Refresh();
+
+    auto it = dimensions.find(dimension);
+    if(it == dimensions.end()) return;
+
+    for(auto& [key, cell] : it->second)
+    {
+        for(Item* item : cell)
+        {
+            if(IsAllowed(allowedTypes, item->type)) result.push_back(item->object);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "cpp-sdk/objects/IWorldObject.h"
+
+// Uniform grid over the positions of all entities, shared by all resources.
+// Entities are added and removed with the base object events and moved to another cell when
+// their position or dimension is set from a script. Positions that change outside of scripts
+// (network sync, physics) are picked up by re-locating all entities on the first query of a tick.
+// The grid is only a broad phase, every candidate is checked against its live position and dimension.
+class CSpatialIndex
+{
+    // Size of a grid cell in units, the grid only uses the x and y axis
+    static constexpr float CELL_SIZE = 64.f;
+
+    struct Item
+    {
+        alt::IWorldObject* object;
+        alt::IBaseObject::Type type;
+        int32_t dimension;
+        uint64_t cell;
+        // Index of the item in its cell
+        uint32_t cellIndex;
+    };
+
+    using Cell = std::vector<Item*>;
+    using Dimension = std::unordered_map<uint64_t, Cell>;
+
+    // Amount of started resources, the index is only kept while one receives the base object events
+    uint32_t users = 0;
+    bool built = false;
+    bool stale = false;
+    std::unordered_map<alt::IBaseObject*, Item> items;
+    std::unordered_map<int32_t, Dimension> dimensions;
+
+    static int32_t GetCellCoord(float val)
+    {
+        return (int32_t)std::floor(val / CELL_SIZE);
+    }
+    static uint64_t GetCellKey(int32_t x, int32_t y)
+    {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    }
+    static uint64_t GetCellKey(const alt::Vector3f& pos)
+    {
+        return GetCellKey(GetCellCoord(pos[0]), GetCellCoord(pos[1]));
+    }
+    static bool IsAllowed(uint64_t allowedTypes, alt::IBaseObject::Type type)
+    {
+        return (allowedTypes & (uint64_t(1) << (uint8_t)type)) != 0;
+    }
+    static bool IsIndexed(alt::IBaseObject::Type type);
+
+    void Clear();
+    // Adds all existing entities, done on the first query so nothing is tracked until the index is used
+    void Build();
+    // Moves every item to its current cell, done on the first query of a tick
+    void Refresh();
+    void Insert(Item& item);
+    void Erase(Item& item);
+    void Relocate(Item& item);
+
+    // Calls fn(object) for every item in the cells that overlap the area
+    template<typename Func>
+    void ForEachInArea(const alt::Vector3f& min, const alt::Vector3f& max, std::optional<int32_t> dimension, Func&& fn);
+
+public:
+    using Result = std::vector<alt::IBaseObject*>;
+
+    static constexpr uint64_t ALL_TYPES = std::numeric_limits<uint64_t>::max();
+
+    static CSpatialIndex& Instance()
+    {
+        static CSpatialIndex instance;
+        return instance;
+    }
+
+    void Acquire()
+    {
+        users++;
+    }
+    void Release();
+
+    void Add(alt::IBaseObject* object);
+    void Remove(alt::IBaseObject* object);
+    // Called after the position or dimension of an entity was set
+    void Update(alt::IBaseObject* object);
+
+    // Entities may have moved without a script setting their position
+    void Invalidate()
+    {
+        stale = true;
+    }
+
+    // When no dimension is passed, entities of every dimension are returned
+    void GetInRange(const alt::Vector3f& pos, float range, std::optional<int32_t> dimension, uint64_t allowedTypes, Result& result);
+    void GetInBox(const alt::Vector3f& min, const alt::Vector3f& max, std::optional<int32_t> dimension, uint64_t allowedTypes, Result& result);
+    // Sorted by distance, closest first
+    void GetClosest(const alt::Vector3f& pos, float range, std::optional<int32_t> dimension, uint32_t limit, uint64_t allowedTypes, Result& result);
+    void GetInDimension(int32_t dimension, uint64_t allowedTypes, Result& result);
+};
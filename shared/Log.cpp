@@ -1,33 +1,293 @@
 #include "Log.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #ifdef ALT_CLIENT_API
     #include "CV8ScriptRuntime.h"
 #else
     #include "CNodeScriptRuntime.h"
 #endif
 
+// Everything is written until a log level is set
+std::atomic<uint8_t> Log::minLevel = GetLevel(DEBUG);
+
+namespace
+{
+    struct Entry
+    {
+        std::atomic<Entry*> next = nullptr;
+        Log::Type type = Log::INFO;
+        std::string message;
+        alt::IResource* resource = nullptr;
+    };
+
+    class LogQueue
+    {
+        // How long identical lines are collapsed before the repeat count is written
+        static constexpr auto REPEAT_INTERVAL = std::chrono::seconds(1);
+
+        // Intrusive multiple producer single consumer queue, producers never wait for each other or the consumer.
+        // The stub entry keeps the queue non-empty, so pushing is a single exchange.
+        Entry stub;
+        std::atomic<Entry*> head{ &stub };
+        Entry* tail = &stub;
+
+        std::atomic<uint64_t> pushed = 0;
+        std::atomic<uint64_t> processed = 0;
+
+        std::thread thread;
+        std::mutex threadMutex;
+        std::atomic<bool> running = false;
+
+        // Only used to put the consumer to sleep, producers only lock it when the consumer is sleeping
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+        std::atomic<bool> sleeping = false;
+        std::atomic<bool> stopping = false;
+
+        // Last written line, identical lines after it are only counted
+        bool hasLast = false;
+        Log::Type lastType = Log::INFO;
+        std::string lastMessage;
+        alt::IResource* lastResource = nullptr;
+        uint32_t repeats = 0;
+        std::chrono::steady_clock::time_point firstRepeat;
+
+        // Lines that are written directly, before the thread was started or after it was stopped
+        std::mutex directMutex;
+
+        void Push(Entry* entry)
+        {
+            entry->next.store(nullptr, std::memory_order_relaxed);
+            Entry* prev = head.exchange(entry, std::memory_order_acq_rel);
+            prev->next.store(entry, std::memory_order_release);
+        }
+
+        // Returns nullptr if the queue is empty or the next entry is still being pushed
+        Entry* Pop()
+        {
+            Entry* entry = tail;
+            Entry* next = entry->next.load(std::memory_order_acquire);
+            if(entry == &stub)
+            {
+                if(!next) return nullptr;
+                tail = next;
+                entry = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+            if(next)
+            {
+                tail = next;
+                return entry;
+            }
+            if(entry != head.load(std::memory_order_acquire)) return nullptr;
+
+            Push(&stub);
+            next = entry->next.load(std::memory_order_acquire);
+            if(!next) return nullptr;
+            tail = next;
+            return entry;
+        }
+
+        static void Output(Log::Type type, const std::string& message, alt::IResource* resource)
+        {
+            switch(type)
+            {
+                case Log::INFO: alt::ICore::Instance().LogInfo(message, resource); break;
+                case Log::DEBUG: alt::ICore::Instance().LogDebug(message, resource); break;
+                case Log::WARNING: alt::ICore::Instance().LogWarning(message, resource); break;
+                case Log::ERR: alt::ICore::Instance().LogError(message, resource); break;
+                case Log::COLORED: alt::ICore::Instance().LogColored(message, resource); break;
+            }
+        }
+
+        void WriteRepeats()
+        {
+            if(repeats == 0) return;
+            // The resource of the repeated line might already be destroyed
+            Output(lastType, "Last message repeated " + std::to_string(repeats) + (repeats == 1 ? " time" : " times"), nullptr);
+            repeats = 0;
+            // The next identical line is written again, so repeated lines show up about once per interval
+            hasLast = false;
+        }
+
+        void Process(Entry* entry)
+        {
+            if(hasLast && entry->type == lastType && entry->resource == lastResource && entry->message == lastMessage)
+            {
+                if(repeats++ == 0) firstRepeat = std::chrono::steady_clock::now();
+                return;
+            }
+
+            WriteRepeats();
+            Output(entry->type, entry->message, entry->resource);
+            hasLast = true;
+            lastType = entry->type;
+            lastResource = entry->resource;
+            lastMessage = std::move(entry->message);
+        }
+
+        void Run()
+        {
+            while(true)
+            {
+                Entry* entry = Pop();
+                if(entry)
+                {
+                    Process(entry);
+                    delete entry;
+                    processed.fetch_add(1, std::memory_order_release);
+                    processed.notify_all();
+                    continue;
+                }
+
+                if(repeats != 0 && std::chrono::steady_clock::now() - firstRepeat >= REPEAT_INTERVAL) WriteRepeats();
+
+                std::unique_lock lock(sleepMutex);
+                sleeping = true;
+                // An entry is being pushed, it will be available right away
+                if(pushed.load() != processed.load(std::memory_order_relaxed))
+                {
+                    sleeping = false;
+                    lock.unlock();
+                    std::this_thread::yield();
+                    continue;
+                }
+                if(stopping) break;
+                sleepCondition.wait_for(lock, REPEAT_INTERVAL);
+                sleeping = false;
+            }
+            WriteRepeats();
+        }
+
+        void Start()
+        {
+            std::scoped_lock lock(threadMutex);
+            if(running || stopping) return;
+            thread = std::thread(&LogQueue::Run, this);
+            running = true;
+        }
+
+    public:
+        static LogQueue& Instance()
+        {
+            // Never destroyed, the thread is stopped by Shutdown when the runtime is disposed
+            static LogQueue* instance = new LogQueue();
+            return *instance;
+        }
+
+        void Write(Log::Type type, std::string&& message, alt::IResource* resource)
+        {
+            if(!running.load(std::memory_order_acquire)) Start();
+
+            if(stopping)
+            {
+                std::scoped_lock lock(directMutex);
+                Output(type, message, resource);
+                return;
+            }
+
+            Entry* entry = new Entry();
+            entry->type = type;
+            entry->message = std::move(message);
+            entry->resource = resource;
+            pushed.fetch_add(1);
+            Push(entry);
+
+            if(sleeping.load())
+            {
+                std::scoped_lock lock(sleepMutex);
+                sleepCondition.notify_one();
+            }
+        }
+
+        void Flush()
+        {
+            uint64_t target = pushed.load();
+            uint64_t current;
+            while((current = processed.load(std::memory_order_acquire)) < target) processed.wait(current);
+        }
+
+        void Shutdown()
+        {
+            std::scoped_lock lock(threadMutex);
+            if(!running) return;
+            {
+                std::scoped_lock sleepLock(sleepMutex);
+                stopping = true;
+                sleepCondition.notify_one();
+            }
+            thread.join();
+
+            // Lines that were queued while the thread was stopping
+            while(Entry* entry = Pop())
+            {
+                Process(entry);
+                delete entry;
+                processed.fetch_add(1, std::memory_order_release);
+            }
+            WriteRepeats();
+            processed.notify_all();
+            running = false;
+        }
+    };
+}  // namespace
+
 Log& Log::Endl(Log& log)
 {
+    if(log.skip)
+    {
+        log.skip = false;
+        return log;
+    }
+
     v8::Isolate* isolate = nullptr;
 #ifdef ALT_CLIENT_API
     isolate = CV8ScriptRuntime::Instance().GetIsolate();
 #else
     isolate = CNodeScriptRuntime::Instance().GetIsolate();
 #endif
+    // Only the thread that is currently using the isolate can access its context
+    if(isolate != v8::Isolate::TryGetCurrent()) isolate = nullptr;
     v8::Local<v8::Context> ctx;
     if(isolate) ctx = isolate->GetEnteredOrMicrotaskContext();
     V8ResourceImpl* v8Resource = !ctx.IsEmpty() ? V8ResourceImpl::Get(ctx) : nullptr;
     alt::IResource* resource = v8Resource ? v8Resource->GetResource() : nullptr;
 
-    switch(log.type)
-    {
-        case INFO: alt::ICore::Instance().LogInfo(log.buf.str(), resource); break;
-        case DEBUG: alt::ICore::Instance().LogDebug(log.buf.str().c_str(), resource); break;
-        case WARNING: alt::ICore::Instance().LogWarning(log.buf.str().c_str(), resource); break;
-        case ERR: alt::ICore::Instance().LogError(log.buf.str().c_str(), resource); break;
-        case COLORED: alt::ICore::Instance().LogColored(log.buf.str().c_str(), resource); break;
-    }
+    Write(log.type, log.buf.str(), resource);
 
     log.buf.str("");
     return log;
 }
+
+bool Log::SetLevel(const std::string& name)
+{
+    if(name == "debug") SetLevel(DEBUG);
+    else if(name == "info")
+        SetLevel(INFO);
+    else if(name == "warning")
+        SetLevel(WARNING);
+    else if(name == "error")
+        SetLevel(ERR);
+    else
+        return false;
+    return true;
+}
+
+void Log::Write(Type type, std::string&& message, alt::IResource* resource)
+{
+    LogQueue::Instance().Write(type, std::move(message), resource);
+}
+
+void Log::Flush()
+{
+    LogQueue::Instance().Flush();
+}
+
+void Log::Shutdown()
+{
+    LogQueue::Instance().Shutdown();
+}
@@ -1,15 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <sstream>
+#include <string>
 #include "cpp-sdk/ICore.h"
 
+// Every thread formats its lines in its own buffer, finished lines are queued and written to the console
+// by a background thread, so logging never blocks on console output and lines of different threads don't mix.
 class Log
 {
-    std::stringstream buf;
-
-    typedef Log& (*LogFn)(Log&);
-    static Log* _Instance;
-
+public:
     enum Type
     {
         INFO,
@@ -17,10 +17,31 @@ class Log
         WARNING,
         ERR,
         COLORED
-    } type = INFO;
+    };
+
+private:
+    std::stringstream buf;
+
+    typedef Log& (*LogFn)(Log&);
+
+    Type type = INFO;
+    // Set when the type is below the log level, nothing is formatted until the next Endl
+    bool skip = false;
 
     Log() = default;
 
+    static uint8_t GetLevel(Type type)
+    {
+        switch(type)
+        {
+            case DEBUG: return 0;
+            case WARNING: return 2;
+            case ERR: return 3;
+            default: return 1;
+        }
+    }
+    static std::atomic<uint8_t> minLevel;
+
 public:
     Log(const Log&) = delete;
     Log(Log&&) = delete;
@@ -29,13 +50,13 @@ public:
     template<class T>
     Log& Put(const T& val)
     {
-        buf << val;
+        if(!skip) buf << val;
         return *this;
     }
 #if __cplusplus >= 202002L
     Log& Put(const char8_t* val)
     {
-        buf << (const char*)val;
+        if(!skip) buf << (const char*)val;
         return *this;
     }
 #endif  // __cplusplus
@@ -46,6 +67,7 @@ public:
     Log& SetType(Type _type)
     {
         type = _type;
+        skip = !IsEnabled(_type);
         return *this;
     }
     template<class T>
@@ -103,7 +125,26 @@ public:
 
     static Log& Instance()
     {
-        static Log _Instance;
+        thread_local Log _Instance;
         return _Instance;
     }
+
+    // Lines below the level are dropped before they are formatted
+    static bool IsEnabled(Type type)
+    {
+        return GetLevel(type) >= minLevel.load(std::memory_order_relaxed);
+    }
+    static void SetLevel(Type type)
+    {
+        minLevel.store(GetLevel(type), std::memory_order_relaxed);
+    }
+    // Returns false if the name is not a valid level (debug, info, warning, error)
+    static bool SetLevel(const std::string& name);
+
+    // Queues a finished line, the resource is only used for the prefix and has to stay valid until the next Flush
+    static void Write(Type type, std::string&& message, alt::IResource* resource = nullptr);
+    // Blocks until all lines queued before the call were written
+    static void Flush();
+    // Writes the remaining lines and stops the background thread, later lines are written directly
+    static void Shutdown();
 };
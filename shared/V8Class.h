@@ -61,6 +61,14 @@ public:
 
     v8::Local<v8::Value> CreateInstance(v8::Isolate* isolate, v8::Local<v8::Context> ctx, std::vector<v8::Local<v8::Value>> args);
 
+    // Empty if the class isn't loaded in the isolate
+    v8::Local<v8::FunctionTemplate> GetTemplate(v8::Isolate* isolate)
+    {
+        auto it = tplMap.find(isolate);
+        if(it == tplMap.end()) return v8::Local<v8::FunctionTemplate>();
+        return it->second.Get(isolate);
+    }
+
     v8::Local<v8::Function> JSValue(v8::Isolate* isolate, v8::Local<v8::Context> ctx)
     {
         return tplMap.at(isolate).Get(isolate)->GetFunction(ctx).ToLocalChecked();
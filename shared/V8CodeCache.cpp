@@ -0,0 +1,262 @@
+#include "V8CodeCache.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#include "V8Helpers.h"
+#include "JSBindings.h"
+#include "Log.h"
+
+#ifdef ALT_CLIENT_API
+static const std::vector<std::string> bindingsParams = { "alt", "native", "__global" };
+#else
+static const std::vector<std::string> bindingsParams = { "alt", "__global" };
+#endif
+
+// Header of the cache files of user modules, followed by the cache data
+struct UserModuleHeader
+{
+    static constexpr uint32_t MAGIC = 0x43434A41; // "AJCC"
+
+    uint32_t magic;
+    uint32_t size;
+    uint64_t sourceHash;
+};
+
+static int64_t GetTimeMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t V8CodeCache::GetKey(const std::string& source, const std::vector<std::string>& params)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const char* data, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            hash ^= (uint8_t)data[i];
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xff;
+        hash *= 1099511628211ull;
+    };
+
+    // The cache data is only valid for the V8 version that created it
+    const char* version = v8::V8::GetVersion();
+    add(version, strlen(version));
+    for(auto& param : params) add(param.data(), param.size());
+    add(source.data(), source.size());
+    return hash;
+}
+
+V8CodeCache::Data V8CodeCache::Get(uint64_t key)
+{
+    std::scoped_lock lock(mutex);
+    auto it = entries.find(key);
+    if(it == entries.end()) return nullptr;
+    return it->second;
+}
+
+void V8CodeCache::Set(uint64_t key, v8::ScriptCompiler::CachedData* cachedData)
+{
+    if(!cachedData) return;
+    Data data = std::make_shared<const std::vector<uint8_t>>(cachedData->data, cachedData->data + cachedData->length);
+    delete cachedData;
+
+    std::scoped_lock lock(mutex);
+    entries[key] = std::move(data);
+}
+
+void V8CodeCache::AddSample(Counters& counters, bool wasCached, bool wasRejected, int64_t time)
+{
+    std::scoped_lock lock(mutex);
+    Stats& stats = wasCached ? counters.cached : counters.cold;
+    stats.count++;
+    stats.time += time;
+    if(wasRejected) counters.rejected++;
+}
+
+v8::MaybeLocal<v8::Module> V8CodeCache::Compile(v8::Isolate* isolate, const std::string& name, const std::string& source, const uint8_t* data, size_t size, bool& wasRejected)
+{
+    v8::ScriptOrigin origin(isolate, V8Helpers::JSValue(name), 0, 0, false, -1, v8::Local<v8::Value>(), false, false, true, v8::Local<v8::PrimitiveArray>());
+    // The source takes ownership of the cached data object, but not of the buffer, that one is kept alive by the caller
+    v8::ScriptCompiler::CachedData* cachedData = data ? new v8::ScriptCompiler::CachedData(data, (int)size) : nullptr;
+    v8::ScriptCompiler::Source compilerSource{ V8Helpers::JSValue(source), origin, cachedData };
+    v8::MaybeLocal<v8::Module> maybeModule =
+      v8::ScriptCompiler::CompileModule(isolate, &compilerSource, data ? v8::ScriptCompiler::kConsumeCodeCache : v8::ScriptCompiler::kNoCompileOptions);
+
+    wasRejected = data && compilerSource.GetCachedData()->rejected;
+    if(wasRejected) Log::Warning << "[V8] Code cache of " << name << " was rejected, recreating it" << Log::Endl;
+    return maybeModule;
+}
+
+v8::MaybeLocal<v8::Module> V8CodeCache::CompileModule(v8::Isolate* isolate, const std::string& name, const std::string& source)
+{
+    V8CodeCache& cache = Instance();
+    uint64_t key = GetKey(source);
+    Data data = cache.Get(key);
+
+    int64_t start = GetTimeMicroseconds();
+    bool wasRejected;
+    v8::MaybeLocal<v8::Module> maybeModule = Compile(isolate, name, source, data ? data->data() : nullptr, data ? data->size() : 0, wasRejected);
+    cache.AddSample(cache.embedded, data && !wasRejected, wasRejected, GetTimeMicroseconds() - start);
+
+    v8::Local<v8::Module> module;
+    if((!data || wasRejected) && maybeModule.ToLocal(&module)) cache.Set(key, v8::ScriptCompiler::CreateCodeCache(module->GetUnboundModuleScript()));
+
+    return maybeModule;
+}
+
+v8::MaybeLocal<v8::Module> V8CodeCache::CompileUserModule(
+  v8::Isolate* isolate, const std::string& resourceName, const std::string& name, const std::string& source, std::vector<PendingModule>& pending)
+{
+    V8CodeCache& cache = Instance();
+    std::filesystem::path dir;
+    {
+        std::scoped_lock lock(cache.mutex);
+        dir = cache.userModulesDir;
+    }
+
+    bool wasRejected;
+    if(dir.empty()) return Compile(isolate, name, source, nullptr, 0, wasRejected);
+
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.bin", (unsigned long long)GetKey(name, { resourceName }));
+    std::filesystem::path file = dir / fileName;
+    uint64_t sourceHash = GetKey(source);
+
+    // A missing file, or one written for another version of the source, is a cold compile
+    std::vector<uint8_t> data;
+    std::ifstream stream(file, std::ios::binary);
+    UserModuleHeader header;
+    // The size in the header is only trusted if the file has that much data, a corrupt file could force a huge allocation
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(file, error);
+    uintmax_t dataSize = !error && fileSize > sizeof(header) ? fileSize - sizeof(header) : 0;
+    if(stream.read((char*)&header, sizeof(header)) && header.magic == UserModuleHeader::MAGIC && header.sourceHash == sourceHash && header.size <= dataSize)
+    {
+        data.resize(header.size);
+        if(!stream.read((char*)data.data(), header.size)) data.clear();
+    }
+    stream.close();
+
+    int64_t start = GetTimeMicroseconds();
+    v8::MaybeLocal<v8::Module> maybeModule = Compile(isolate, name, source, data.empty() ? nullptr : data.data(), data.size(), wasRejected);
+    cache.AddSample(cache.userModules, !data.empty() && !wasRejected, wasRejected, GetTimeMicroseconds() - start);
+
+    v8::Local<v8::Module> module;
+    if((data.empty() || wasRejected) && maybeModule.ToLocal(&module))
+        pending.push_back(PendingModule{ std::move(file), sourceHash, v8::Global<v8::UnboundModuleScript>(isolate, module->GetUnboundModuleScript()) });
+
+    return maybeModule;
+}
+
+void V8CodeCache::SaveUserModules(v8::Isolate* isolate, std::vector<PendingModule>& pending)
+{
+    v8::HandleScope handleScope(isolate);
+    for(auto& module : pending)
+    {
+        std::unique_ptr<v8::ScriptCompiler::CachedData> cachedData{ v8::ScriptCompiler::CreateCodeCache(module.script.Get(isolate)) };
+        if(!cachedData) continue;
+
+        std::error_code error;
+        std::filesystem::create_directories(module.file.parent_path(), error);
+
+        // Written to a temporary file first, so a partially written cache is never read
+        std::filesystem::path tempFile = module.file;
+        tempFile += ".tmp";
+        {
+            std::ofstream stream(tempFile, std::ios::binary | std::ios::trunc);
+            UserModuleHeader header{ UserModuleHeader::MAGIC, (uint32_t)cachedData->length, module.sourceHash };
+            stream.write((const char*)&header, sizeof(header));
+            stream.write((const char*)cachedData->data, cachedData->length);
+            if(!stream) continue;
+        }
+        std::filesystem::rename(tempFile, module.file, error);
+        if(error) Log::Warning << "[V8] Failed to write code cache " << module.file.string() << ": " << error.message() << Log::Endl;
+    }
+    pending.clear();
+}
+
+void V8CodeCache::SetUserModulesDir(const std::filesystem::path& dir)
+{
+    V8CodeCache& cache = Instance();
+    std::scoped_lock lock(cache.mutex);
+    cache.userModulesDir = dir;
+}
+
+v8::MaybeLocal<v8::Value> V8CodeCache::RunFunction(v8::Local<v8::Context> ctx,
+                                                   const std::string& name,
+                                                   const std::string& source,
+                                                   const std::vector<std::string>& params,
+                                                   std::vector<v8::Local<v8::Value>>& args)
+{
+    v8::Isolate* isolate = ctx->GetIsolate();
+    V8CodeCache& cache = Instance();
+    uint64_t key = GetKey(source, params);
+    Data data = cache.Get(key);
+
+    std::vector<v8::Local<v8::String>> paramNames;
+    paramNames.reserve(params.size());
+    for(auto& param : params) paramNames.push_back(V8Helpers::JSValue(param));
+
+    int64_t start = GetTimeMicroseconds();
+    v8::ScriptOrigin origin(isolate, V8Helpers::JSValue(name));
+    v8::ScriptCompiler::CachedData* cachedData = data ? new v8::ScriptCompiler::CachedData(data->data(), (int)data->size()) : nullptr;
+    v8::ScriptCompiler::Source compilerSource{ V8Helpers::JSValue(source), origin, cachedData };
+    v8::MaybeLocal<v8::Function> maybeFunc = v8::ScriptCompiler::CompileFunction(
+      ctx, &compilerSource, paramNames.size(), paramNames.data(), 0, nullptr, data ? v8::ScriptCompiler::kConsumeCodeCache : v8::ScriptCompiler::kNoCompileOptions);
+
+    bool wasRejected = data && compilerSource.GetCachedData()->rejected;
+    cache.AddSample(cache.embedded, data && !wasRejected, wasRejected, GetTimeMicroseconds() - start);
+    if(wasRejected) Log::Warning << "[V8] Code cache of " << name << " was rejected, recreating it" << Log::Endl;
+
+    v8::Local<v8::Function> func;
+    if(!maybeFunc.ToLocal(&func)) return v8::MaybeLocal<v8::Value>();
+
+    v8::MaybeLocal<v8::Value> result = func->Call(ctx, v8::Undefined(isolate), (int)args.size(), args.data());
+    if((!data || wasRejected) && !result.IsEmpty()) cache.Set(key, v8::ScriptCompiler::CreateCodeCacheForFunction(func));
+
+    return result;
+}
+
+void V8CodeCache::LoadBindings(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_CHECK((size_t)info.Length() == bindingsParams.size(), "Invalid bindings arguments");
+
+    std::vector<v8::Local<v8::Value>> args;
+    args.reserve(info.Length());
+    for(int i = 0; i < info.Length(); i++) args.push_back(info[i]);
+
+    // On failure the exception is already pending
+    RunFunction(ctx, "<bindings>", JSBindings::GetBindingsCode(), bindingsParams, args);
+}
+
+void V8CodeCache::PrintStats()
+{
+    V8CodeCache& cache = Instance();
+    std::scoped_lock lock(cache.mutex);
+
+    size_t size = 0;
+    for(auto& [key, data] : cache.entries) size += data->size();
+
+    auto average = [](const Stats& stats) { return stats.count == 0 ? 0.0 : stats.time / 1000.0 / stats.count; };
+
+    Log::Info << "================ Code cache info =================" << Log::Endl;
+    Log::Info << "Entries: " << cache.entries.size() << " (" << size / 1024 << " KB)" << Log::Endl;
+    Log::Info << "Cold compiles: " << cache.embedded.cold.count << ", avg " << average(cache.embedded.cold) << "ms" << Log::Endl;
+    Log::Info << "Cached compiles: " << cache.embedded.cached.count << ", avg " << average(cache.embedded.cached) << "ms" << Log::Endl;
+    Log::Info << "Rejected: " << cache.embedded.rejected << Log::Endl;
+    if(!cache.userModulesDir.empty() || cache.userModules.cold.count != 0)
+    {
+        Log::Info << "User modules: " << cache.userModulesDir.string() << Log::Endl;
+        Log::Info << "  Cold compiles: " << cache.userModules.cold.count << ", avg " << average(cache.userModules.cold) << "ms" << Log::Endl;
+        Log::Info << "  Cached compiles: " << cache.userModules.cached.count << ", avg " << average(cache.userModules.cached) << "ms" << Log::Endl;
+        Log::Info << "  Rejected: " << cache.userModules.rejected << Log::Endl;
+    }
+    Log::Info << "======================================================" << Log::Endl;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "v8.h"
+
+// Process-wide cache of the compiled code of the sources embedded into the module (bindings, bootstrapper),
+// so every resource (and worker) after the first one skips parsing and compiling them.
+// Entries are keyed by a hash of the source and the V8 version, rejected cache data is dropped and recreated.
+// The user modules of client resources are cached on disk instead, so they are also reused across server joins.
+class V8CodeCache
+{
+    using Data = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats
+    {
+        uint32_t count = 0;
+        int64_t time = 0;
+    };
+
+    struct Counters
+    {
+        Stats cold;
+        Stats cached;
+        uint32_t rejected = 0;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Data> entries;
+    Counters embedded;
+    Counters userModules;
+    std::filesystem::path userModulesDir;
+
+    static V8CodeCache& Instance()
+    {
+        static V8CodeCache instance;
+        return instance;
+    }
+
+    static uint64_t GetKey(const std::string& source, const std::vector<std::string>& params = {});
+
+    Data Get(uint64_t key);
+    void Set(uint64_t key, v8::ScriptCompiler::CachedData* cachedData);
+    void AddSample(Counters& counters, bool wasCached, bool wasRejected, int64_t time);
+
+    static v8::MaybeLocal<v8::Module> Compile(v8::Isolate* isolate, const std::string& name, const std::string& source, const uint8_t* data, size_t size, bool& wasRejected);
+
+public:
+    // User module that was compiled without usable cache data, its cache is written once it has run
+    struct PendingModule
+    {
+        std::filesystem::path file;
+        uint64_t sourceHash;
+        v8::Global<v8::UnboundModuleScript> script;
+    };
+
+    static v8::MaybeLocal<v8::Module> CompileModule(v8::Isolate* isolate, const std::string& name, const std::string& source);
+
+    // Compiles a module of a resource with its on-disk cache, the cache file is keyed by the resource and module name
+    // and only used while the source hash stored in it matches. Modules without valid cache are added to pending.
+    static v8::MaybeLocal<v8::Module>
+      CompileUserModule(v8::Isolate* isolate, const std::string& resourceName, const std::string& name, const std::string& source, std::vector<PendingModule>& pending);
+    // Writes the cache of the pending modules, called after they ran so it also contains the lazily compiled functions
+    static void SaveUserModules(v8::Isolate* isolate, std::vector<PendingModule>& pending);
+    // An empty directory disables the cache of user modules
+    static void SetUserModulesDir(const std::filesystem::path& dir);
+
+    // Compiles the source as the body of a function with the given params and calls it with the args.
+    // The cache is created after the call, so it also contains the functions that were compiled lazily.
+    static v8::MaybeLocal<v8::Value> RunFunction(v8::Local<v8::Context> ctx,
+                                                 const std::string& name,
+                                                 const std::string& source,
+                                                 const std::vector<std::string>& params,
+                                                 std::vector<v8::Local<v8::Value>>& args);
+
+    // Runs the embedded JS bindings code, called from the bootstrapper as __internal_load_bindings
+    static void LoadBindings(const v8::FunctionCallbackInfo<v8::Value>& info);
+
+    // Logs the cold and cached compile times of the embedded code and the user modules
+    static void PrintStats();
+};
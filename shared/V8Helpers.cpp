@@ -2,6 +2,7 @@
 #include "cpp-sdk/ICore.h"
 #include "V8ResourceImpl.h"
 #include "V8Helpers.h"
+#include "V8Watchdog.h"
 #ifdef ALT_CLIENT
     #include "CV8Resource.h"
 #endif
@@ -22,6 +23,9 @@ bool V8Helpers::TryCatch(const std::function<bool()>& fn)
 
     if(!fn())
     {
+        // Terminated calls are reported by whoever terminated them (watchdog, worker shutdown)
+        if(tryCatch.HasTerminated()) return false;
+
         v8::Local<v8::Value> exception = tryCatch.Exception();
         v8::Local<v8::Message> message = tryCatch.Message();
 
@@ -348,7 +352,31 @@ v8::Local<v8::String> V8Helpers::Fire_WeaponKey(v8::Isolate* isolate)
     return aKey.Get(isolate);
 }
 
-std::vector<V8Helpers::EventCallback*> V8Helpers::EventHandler::GetCallbacks(V8ResourceImpl* impl, const alt::CEvent* e)
+uint32_t V8Helpers::EventNames::Intern(const std::string& name)
+{
+    auto& _ids = ids();
+    auto it = _ids.find(name);
+    if(it != _ids.end()) return it->second;
+
+    uint32_t id = (uint32_t)names().size();
+    names().push_back(name);
+    _ids.insert({ name, id });
+    return id;
+}
+
+uint32_t V8Helpers::EventNames::Find(const std::string& name)
+{
+    auto& _ids = ids();
+    auto it = _ids.find(name);
+    return (it != _ids.end()) ? it->second : INVALID_ID;
+}
+
+const std::string& V8Helpers::EventNames::GetName(uint32_t id)
+{
+    return names().at(id);
+}
+
+V8Helpers::EventCallbackSpan V8Helpers::EventHandler::GetCallbacks(V8ResourceImpl* impl, const alt::CEvent* e)
 {
     return callbacksGetter(impl, e);
 }
@@ -397,7 +425,8 @@ void V8Helpers::EventHandler::Register(alt::CEvent::Type type, EventHandler* han
 
 V8Helpers::EventHandler::CallbacksGetter V8Helpers::LocalEventHandler::GetCallbacksGetter(const std::string& name)
 {
-    return [name](V8ResourceImpl* resource, const alt::CEvent*) -> std::vector<EventCallback*> { return resource->GetLocalHandlers(name); };
+    uint32_t id = EventNames::Intern(name);
+    return [id](V8ResourceImpl* resource, const alt::CEvent*) { return resource->GetLocalHandlers(id); };
 }
 
 V8Helpers::EventHandler::EventHandler(alt::CEvent::Type type, CallbacksGetter&& _handlersGetter, ArgsGetter&& _argsGetter)
@@ -463,24 +492,29 @@ std::string V8Helpers::GetJSValueTypeName(v8::Local<v8::Value> val)
         return "unknown";
 }
 
-v8::MaybeLocal<v8::Value> V8Helpers::CallFunctionWithTimeout(v8::Local<v8::Function> fn, v8::Local<v8::Context> ctx, std::vector<v8::Local<v8::Value>>& args, uint32_t timeout)
+v8::MaybeLocal<v8::Value> V8Helpers::CallFunctionWithTimeout(v8::Local<v8::Function> fn, v8::Local<v8::Context> ctx, std::vector<v8::Local<v8::Value>>& args, std::string_view name, uint32_t timeout)
 {
     v8::Isolate* isolate = ctx->GetIsolate();
-    /*std::shared_ptr<bool> hasTimedOut{ new bool(false) };
-    std::shared_ptr<bool> hasFinished{ new bool(false) };
-    std::thread([=]() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
-        if(*hasFinished || isolate->IsExecutionTerminating()) return;
-        *hasTimedOut = true;
-        isolate->TerminateExecution();
-    }).detach();*/
+    V8ResourceImpl* v8resource = V8ResourceImpl::Get(ctx);
+    // Worker contexts reference the resource too, but the worker runs on its own thread and doesn't block the tick
+    bool isWorker = *static_cast<bool*>(isolate->GetData(v8::Isolate::GetNumberOfDataSlots() - 1));
+    if(timeout == 0) timeout = isWorker ? V8Watchdog::Instance().GetWorkerTimeout() : v8resource ? v8resource->GetExecutionTimeout() : 0;
 
+    V8Watchdog::Scope watchdog(isolate, timeout);
     v8::MaybeLocal<v8::Value> result = fn->Call(ctx, v8::Undefined(isolate), args.size(), args.data());
-    /**hasFinished = true;
-    if(*hasTimedOut)
+    watchdog.Finish();
+
+    if(watchdog.HasTimedOut())
     {
-        Log::Error << "[V8] Script execution timed out" << Log::Endl;
+        std::string resourceName = v8resource ? v8resource->GetResource()->GetName() : "<unknown>";
+        if(isWorker) resourceName += " (worker)";
+        v8::Local<v8::Value> fileName = fn->GetScriptOrigin().ResourceName();
+        std::string location = fileName->IsString() ? *v8::String::Utf8Value(isolate, fileName) : "<unknown>";
+        if(fn->GetScriptLineNumber() != v8::Function::kLineOffsetNotFound) location += ":" + std::to_string(fn->GetScriptLineNumber() + 1);
+
+        Log::Error << "[V8] Script execution in resource " << resourceName << " exceeded its budget of " << timeout << "ms and was terminated" << Log::Endl;
+        Log::Error << "  " << (name.empty() ? "Function" : name) << " at " << location << Log::Endl;
         return v8::MaybeLocal<v8::Value>();
-    }*/
+    }
     return result;
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
 #include <functional>
+#include <string_view>
 
 #include <v8.h>
 #include <limits>
@@ -49,6 +53,11 @@ namespace V8Helpers
     {
     public:
         SourceLocation(std::string&& fileName, int line, v8::Local<v8::Context> ctx);
+        ~SourceLocation()
+        {
+            // CPersistent doesn't reset on destruction
+            context.Reset();
+        }
 
         const std::string& GetFileName() const
         {
@@ -101,14 +110,155 @@ namespace V8Helpers
         SourceLocation location;
         bool removed = false;
         bool once;
+        // Interned name of the event, INVALID_ID for generic handlers
+        uint32_t eventId = std::numeric_limits<uint32_t>::max();
 
         EventCallback(v8::Isolate* isolate, v8::Local<v8::Function> _fn, SourceLocation&& location, bool once = false) : fn(isolate, _fn), location(std::move(location)), once(once) {}
     };
 
+    // Name of the server event that carries the client events batched during a tick,
+    // its only argument is a list of alternating event names and argument lists
+    constexpr const char* CLIENT_EVENT_BATCH = "__jsClientEventBatch";
+
+    // Interns event names to compact ids, so dispatching doesn't have to hash the name again.
+    // Ids are shared by all resources and are only valid on the main thread.
+    class EventNames
+    {
+    public:
+        static constexpr uint32_t INVALID_ID = std::numeric_limits<uint32_t>::max();
+
+        static uint32_t Intern(const std::string& name);
+        // Returns INVALID_ID if nobody ever subscribed to the event, so unknown names don't grow the table
+        static uint32_t Find(const std::string& name);
+        static const std::string& GetName(uint32_t id);
+
+    private:
+        static std::unordered_map<std::string, uint32_t>& ids()
+        {
+            static std::unordered_map<std::string, uint32_t> _ids;
+            return _ids;
+        }
+        static std::deque<std::string>& names()
+        {
+            static std::deque<std::string> _names;
+            return _names;
+        }
+    };
+
+    // Callbacks subscribed to one event, removed callbacks are only flagged
+    // and erased by Compact(), which must not run while the list is dispatched
+    class EventCallbackList
+    {
+    public:
+        EventCallback& Add(v8::Isolate* isolate, v8::Local<v8::Function> fn, SourceLocation&& location, bool once)
+        {
+            callbacks.push_back(std::make_unique<EventCallback>(isolate, fn, std::move(location), once));
+            return *callbacks.back();
+        }
+
+        EventCallback* operator[](size_t index) const
+        {
+            return callbacks[index].get();
+        }
+        size_t size() const
+        {
+            return callbacks.size();
+        }
+        bool empty() const
+        {
+            return callbacks.empty();
+        }
+
+        void Clear()
+        {
+            callbacks.clear();
+        }
+
+        void Compact()
+        {
+            callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [](const std::unique_ptr<EventCallback>& cb) { return cb->removed; }), callbacks.end());
+        }
+
+    private:
+        std::vector<std::unique_ptr<EventCallback>> callbacks;
+    };
+
+    // Event callback lists of a resource, indexed by the interned event name id
+    class EventCallbackTable
+    {
+    public:
+        EventCallbackList& GetOrCreate(uint32_t id)
+        {
+            if(id >= lists.size()) lists.resize(id + 1);
+            if(!lists[id]) lists[id] = std::make_unique<EventCallbackList>();
+            return *lists[id];
+        }
+
+        EventCallbackList* Get(uint32_t id) const
+        {
+            if(id >= lists.size()) return nullptr;
+            return lists[id].get();
+        }
+
+        template<typename Func>
+        void ForEach(Func&& fn) const
+        {
+            for(uint32_t id = 0; id < lists.size(); id++)
+            {
+                if(lists[id]) fn(id, *lists[id]);
+            }
+        }
+
+        void Compact()
+        {
+            for(auto& list : lists)
+            {
+                if(list) list->Compact();
+            }
+        }
+
+        void Clear()
+        {
+            lists.clear();
+        }
+
+    private:
+        std::vector<std::unique_ptr<EventCallbackList>> lists;
+    };
+
+    // The callbacks to invoke for one dispatch. Only the callbacks that were subscribed
+    // when it was created are visited, and it stays valid while callbacks are added.
+    // Callbacks stored outside of an EventCallbackList are copied into the span.
+    class EventCallbackSpan
+    {
+    public:
+        EventCallbackSpan() = default;
+        EventCallbackSpan(const EventCallbackList* _list) : list(_list), count(_list ? _list->size() : 0) {}
+        EventCallbackSpan(std::vector<EventCallback*> callbacks) : owned(std::move(callbacks)), count(owned.size()) {}
+
+        EventCallback* operator[](size_t index) const
+        {
+            return list ? (*list)[index] : owned[index];
+        }
+        size_t size() const
+        {
+            return count;
+        }
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+    private:
+        const EventCallbackList* list = nullptr;
+        std::vector<EventCallback*> owned;
+        size_t count = 0;
+    };
+
     class EventHandler
     {
     public:
-        using CallbacksGetter = std::function<std::vector<EventCallback*>(V8ResourceImpl* resource, const alt::CEvent*)>;
+        using CallbacksGetter = std::function<EventCallbackSpan(V8ResourceImpl* resource, const alt::CEvent*)>;
         using ArgsGetter = std::function<void(V8ResourceImpl* resource, const alt::CEvent*, std::vector<v8::Local<v8::Value>>& args)>;
 
         EventHandler(alt::CEvent::Type type, CallbacksGetter&& _handlersGetter, ArgsGetter&& _argsGetter);
@@ -116,7 +266,7 @@ namespace V8Helpers
         // Temp issue fix for https://stackoverflow.com/questions/9459980/c-global-variable-not-initialized-when-linked-through-static-libraries-but-ok
         void Reference();
 
-        std::vector<V8Helpers::EventCallback*> GetCallbacks(V8ResourceImpl* impl, const alt::CEvent* e);
+        EventCallbackSpan GetCallbacks(V8ResourceImpl* impl, const alt::CEvent* e);
         std::vector<v8::Local<v8::Value>> GetArgs(V8ResourceImpl* impl, const alt::CEvent* e);
 
         alt::CEvent::Type GetType()
@@ -213,6 +363,8 @@ namespace V8Helpers
         return *strValue;
     }
 
-    v8::MaybeLocal<v8::Value> CallFunctionWithTimeout(v8::Local<v8::Function> fn, v8::Local<v8::Context> ctx, std::vector<v8::Local<v8::Value>>& args, uint32_t timeout = 5000);
+    // Terminates the call once it exceeds the timeout, 0 uses the execution budget of the resource.
+    // The name (event, timer, etc.) is used to report the timed out call.
+    v8::MaybeLocal<v8::Value> CallFunctionWithTimeout(v8::Local<v8::Function> fn, v8::Local<v8::Context> ctx, std::vector<v8::Local<v8::Value>>& args, std::string_view name = {}, uint32_t timeout = 0);
 
 }  // namespace V8Helpers
@@ -3,6 +3,9 @@
 #include "cpp-sdk/objects/IVehicle.h"
 
 #include "V8ResourceImpl.h"
+#include "CProfiler.h"
+#include "CSpatialIndex.h"
+#include "V8Watchdog.h"
 
 #ifdef ALT_SERVER_API
     #include "CNodeResourceImpl.h"
@@ -25,47 +28,59 @@ bool V8ResourceImpl::Start()
     rgbaClass.Reset(isolate, v8RGBA.JSValue(isolate, GetContext()));
     baseObjectClass.Reset(isolate, v8BaseObject.JSValue(isolate, GetContext()));
 
+    Config::Value::ValuePtr timeout = resource->GetConfig()["executionTimeout"];
+    executionTimeout = timeout->IsNone() ? V8Watchdog::Instance().GetDefaultTimeout() : (uint32_t)timeout->AsNumber(0);
+
+    if(!usesSpatialIndex)
+    {
+        CSpatialIndex::Instance().Acquire();
+        usesSpatialIndex = true;
+    }
+
     return true;
 }
 
 bool V8ResourceImpl::Stop()
 {
-    {
-        for(auto& handler : localHandlers)
-        {
-            alt::CEvent::Type type = V8Helpers::EventHandler::GetTypeForEventName(handler.first);
-            if(type != alt::CEvent::Type::NONE) IRuntimeEventHandler::Instance().EventHandlerRemoved(type);
-        }
-    }
+    localHandlers.ForEach(
+      [](uint32_t id, const V8Helpers::EventCallbackList& handlers)
+      {
+          alt::CEvent::Type type = V8Helpers::EventHandler::GetTypeForEventName(V8Helpers::EventNames::GetName(id));
+          if(type == alt::CEvent::Type::NONE) return;
+          for(size_t i = 0; i < handlers.size(); i++) IRuntimeEventHandler::Instance().EventHandlerRemoved(type);
+      });
 
-    for(auto pair : timers)
+    timers.Clear();
+    if(usesSpatialIndex)
     {
-        delete pair.second;
+        CSpatialIndex::Instance().Release();
+        usesSpatialIndex = false;
     }
-    timers.clear();
     for(auto ent : entities)
     {
         delete ent.second;
     }
     entities.clear();
-    oldTimers.clear();
     resourceObjects.clear();
     nextTickCallbacks.clear();
     benchmarkTimers.clear();
 
-    localHandlers.clear();
-    remoteHandlers.clear();
-    localGenericHandlers.clear();
-    remoteGenericHandlers.clear();
-
-    players.Reset();
-    vehicles.Reset();
+    localHandlers.Clear();
+    remoteHandlers.Clear();
+    localGenericHandlers.Clear();
+    remoteGenericHandlers.Clear();
+    handlersRemoved = false;
+
+    // CPersistent doesn't reset on destruction
+    for(auto& [type, pool] : pools) pool.array.Reset();
+    pools.clear();
+    weaponObjects.Reset();
+    weaponObjectPoolDirty = true;
     vector3Class.Reset();
     vector2Class.Reset();
     quaternionClass.Reset();
     rgbaClass.Reset();
     baseObjectClass.Reset();
-    objects.Reset();
 
     context.Reset();
 
@@ -77,58 +92,41 @@ void V8ResourceImpl::OnTick()
     for(auto& nextTickCb : nextTickCallbacks) nextTickCb();
     nextTickCallbacks.clear();
 
-    for(auto& id : oldTimers) timers.erase(id);
-
-    oldTimers.clear();
-
-    for(auto& p : timers)
-    {
-        if(std::find(oldTimers.begin(), oldTimers.end(), p.first) != oldTimers.end()) continue;
-        int64_t time = GetTime();
-        if(!p.second->Update(time)) RemoveTimer(p.first);
-
-        if(GetTime() - time > 50)
-        {
-            auto& location = p.second->GetLocation();
-
-            if(location.GetLineNumber() != 0)
-            {
-                Log::Warning << "Timer at " << resource->GetName() << ":" << location.GetFileName() << ":" << location.GetLineNumber() << " was too long " << GetTime() - time << "ms"
-                             << Log::Endl;
-            }
-            else
-            {
-                Log::Warning << "Timer at " << resource->GetName() << ":" << location.GetFileName() << " was too long " << GetTime() - time << "ms" << Log::Endl;
-            }
-        }
-    }
-
-    for(auto it = localHandlers.begin(); it != localHandlers.end();)
-    {
-        if(it->second.removed) it = localHandlers.erase(it);
-        else
-            ++it;
-    }
-
-    for(auto it = remoteHandlers.begin(); it != remoteHandlers.end();)
-    {
-        if(it->second.removed) it = remoteHandlers.erase(it);
-        else
-            ++it;
-    }
+    timers.Update(GetTime(),
+                  [&](uint32_t id, V8Timer& timer)
+                  {
+                      int64_t time = GetTime();
+                      int64_t lateness = time - timer.GetNextRun();
+                      int64_t start = V8ResourceMetrics::Now();
+                      bool keep = timer.Update(time);
+                      // Timers that are not due yet don't run
+                      if(lateness >= 0) metrics.AddTimer(timer.GetInterval() != 0 ? lateness * 1000 : -1, V8ResourceMetrics::Now() - start);
+
+                      if(GetTime() - time > 50)
+                      {
+                          auto& location = timer.GetLocation();
+
+                          if(location.GetLineNumber() != 0)
+                          {
+                              Log::Warning << "Timer at " << resource->GetName() << ":" << location.GetFileName() << ":" << location.GetLineNumber() << " was too long " << GetTime() - time
+                                           << "ms" << Log::Endl;
+                          }
+                          else
+                          {
+                              Log::Warning << "Timer at " << resource->GetName() << ":" << location.GetFileName() << " was too long " << GetTime() - time << "ms" << Log::Endl;
+                          }
+                      }
 
-    for(auto it = localGenericHandlers.begin(); it != localGenericHandlers.end();)
-    {
-        if(it->removed) it = localGenericHandlers.erase(it);
-        else
-            ++it;
-    }
+                      return keep;
+                  });
 
-    for(auto it = remoteGenericHandlers.begin(); it != remoteGenericHandlers.end();)
+    if(handlersRemoved && dispatchDepth == 0)
     {
-        if(it->removed) it = remoteGenericHandlers.erase(it);
-        else
-            ++it;
+        localHandlers.Compact();
+        remoteHandlers.Compact();
+        localGenericHandlers.Compact();
+        remoteGenericHandlers.Compact();
+        handlersRemoved = false;
     }
 
     for (auto it = awaitableRPCHandlers.rbegin(); it != awaitableRPCHandlers.rend(); ++it)
@@ -190,32 +188,47 @@ v8::Local<v8::Value> V8ResourceImpl::GetBaseObjectOrNull(alt::IBaseObject* handl
         return GetOrCreateEntity(handle)->GetJSVal(isolate);
 }
 
+// The instances are created from the instance template of the class and the fields are defined directly,
+// which results in the same object shape as the constructor, without calling it and checking its arguments
 v8::Local<v8::Value> V8ResourceImpl::CreateVector3(alt::Vector3f vec)
 {
-    std::vector<v8::Local<v8::Value>> args{ V8Helpers::JSValue(vec[0]), V8Helpers::JSValue(vec[1]), V8Helpers::JSValue(vec[2]) };
-
-    return v8Vector3.CreateInstance(isolate, GetContext(), args);
+    v8::Local<v8::Context> ctx = GetContext();
+    v8::Local<v8::Object> obj = v8Vector3.CreateInstance(ctx);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Vector3_XKey(isolate), V8Helpers::JSValue(vec[0]), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Vector3_YKey(isolate), V8Helpers::JSValue(vec[1]), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Vector3_ZKey(isolate), V8Helpers::JSValue(vec[2]), v8::PropertyAttribute::ReadOnly);
+    return obj;
 }
 
 v8::Local<v8::Value> V8ResourceImpl::CreateVector2(alt::Vector2f vec)
 {
-    std::vector<v8::Local<v8::Value>> args{ V8Helpers::JSValue(vec[0]), V8Helpers::JSValue(vec[1]) };
-
-    return v8Vector2.CreateInstance(isolate, GetContext(), args);
+    v8::Local<v8::Context> ctx = GetContext();
+    v8::Local<v8::Object> obj = v8Vector2.CreateInstance(ctx);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Vector3_XKey(isolate), V8Helpers::JSValue(vec[0]), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Vector3_YKey(isolate), V8Helpers::JSValue(vec[1]), v8::PropertyAttribute::ReadOnly);
+    return obj;
 }
 
 v8::Local<v8::Value> V8ResourceImpl::CreateQuaternion(alt::Quaternion quat)
 {
-    std::vector<v8::Local<v8::Value>> args{ V8Helpers::JSValue(quat.x), V8Helpers::JSValue(quat.y), V8Helpers::JSValue(quat.z), V8Helpers::JSValue(quat.w) };
-
-    return v8Quaternion.CreateInstance(isolate, GetContext(), args);
+    v8::Local<v8::Context> ctx = GetContext();
+    v8::Local<v8::Object> obj = v8Quaternion.CreateInstance(ctx);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Quaternion_XKey(isolate), V8Helpers::JSValue(quat.x), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Quaternion_YKey(isolate), V8Helpers::JSValue(quat.y), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Quaternion_ZKey(isolate), V8Helpers::JSValue(quat.z), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::Quaternion_WKey(isolate), V8Helpers::JSValue(quat.w), v8::PropertyAttribute::ReadOnly);
+    return obj;
 }
 
 v8::Local<v8::Value> V8ResourceImpl::CreateRGBA(alt::RGBA rgba)
 {
-    std::vector<v8::Local<v8::Value>> args{ V8Helpers::JSValue(rgba.r), V8Helpers::JSValue(rgba.g), V8Helpers::JSValue(rgba.b), V8Helpers::JSValue(rgba.a) };
-
-    return V8Helpers::New(isolate, GetContext(), rgbaClass.Get(isolate), args);
+    v8::Local<v8::Context> ctx = GetContext();
+    v8::Local<v8::Object> obj = v8RGBA.CreateInstance(ctx);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::RGBA_RKey(isolate), V8Helpers::JSValue(rgba.r), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::RGBA_GKey(isolate), V8Helpers::JSValue(rgba.g), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::RGBA_BKey(isolate), V8Helpers::JSValue(rgba.b), v8::PropertyAttribute::ReadOnly);
+    V8Helpers::DefineOwnProperty(isolate, ctx, obj, V8Helpers::RGBA_AKey(isolate), V8Helpers::JSValue(rgba.a), v8::PropertyAttribute::ReadOnly);
+    return obj;
 }
 
 bool V8ResourceImpl::IsVector3(v8::Local<v8::Value> val)
@@ -262,11 +275,13 @@ void V8ResourceImpl::OnCreateBaseObject(alt::IBaseObject* handle)
     }
 
     NotifyPoolUpdate(handle);
+    CSpatialIndex::Instance().Add(handle);
 }
 
 void V8ResourceImpl::OnRemoveBaseObject(alt::IBaseObject* handle)
 {
     NotifyPoolUpdate(handle);
+    CSpatialIndex::Instance().Remove(handle);
 
     v8::Locker locker(isolate);
     v8::Isolate::Scope isolateScope(isolate);
@@ -279,7 +294,8 @@ void V8ResourceImpl::OnRemoveBaseObject(alt::IBaseObject* handle)
     auto entityType = handle->GetType();
     if(entityType == alt::IBaseObject::Type::PLAYER || entityType == alt::IBaseObject::Type::LOCAL_PLAYER || entityType == alt::IBaseObject::Type::VEHICLE)
     {
-        std::vector<V8Helpers::EventCallback*> handlers = GetLocalHandlers("removeEntity");
+        static uint32_t removeEntityId = V8Helpers::EventNames::Intern("removeEntity");
+        V8Helpers::EventCallbackSpan handlers = GetLocalHandlers(removeEntityId);
         std::vector<v8::Local<v8::Value>> args{ ent->GetJSVal(isolate) };
         InvokeEventHandlers(nullptr, handlers, args);
     }
@@ -291,235 +307,55 @@ void V8ResourceImpl::OnRemoveBaseObject(alt::IBaseObject* handle)
 
 void V8ResourceImpl::NotifyPoolUpdate(alt::IBaseObject* ent)
 {
-    switch(ent->GetType())
-    {
-        case alt::IBaseObject::Type::PLAYER: playerPoolDirty = true; break;
-        case alt::IBaseObject::Type::VEHICLE:
-        case alt::IBaseObject::Type::LOCAL_VEHICLE: vehiclePoolDirty = true; break;
-        case alt::IBaseObject::Type::LOCAL_OBJECT:
-            objectPoolDirty = true;
-            weaponObjectPoolDirty = true;
-            break;
-    }
-}
+    alt::IBaseObject::Type type = ent->GetType();
+    InvalidatePool(type);
 
-v8::Local<v8::Array> V8ResourceImpl::GetAllPlayers()
-{
-    if(playerPoolDirty)
-    {
-        playerPoolDirty = false;
-
-        std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::PLAYER);
-        v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-        for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-        players.Reset(isolate, jsAll);
-        jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-        return jsAll;
-    }
-
-    return players.Get(isolate);
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllVehicles()
-{
-    if(vehiclePoolDirty)
+    switch(type)
     {
-        vehiclePoolDirty = false;
-
-        std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::VEHICLE);
-        v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-        for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-        vehicles.Reset(isolate, jsAll);
-        jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-        return jsAll;
+        case alt::IBaseObject::Type::LOCAL_VEHICLE: InvalidatePool(alt::IBaseObject::Type::VEHICLE); break;
+        case alt::IBaseObject::Type::LOCAL_OBJECT: weaponObjectPoolDirty = true; break;
     }
-    return vehicles.Get(isolate);
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllBlips()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::BLIP);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllAudioOutputs()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::AUDIO_OUTPUT);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllVirtualEntityGroups()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::VIRTUAL_ENTITY_GROUP);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllVirtualEntities()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::VIRTUAL_ENTITY);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllCheckpoints()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::CHECKPOINT);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllPeds()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::PED);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-v8::Local<v8::Array> V8ResourceImpl::GetAllMarkers()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::MARKER);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
 }
 
-v8::Local<v8::Array> V8ResourceImpl::GetAllColshapes()
+template<class T>
+static v8::Local<v8::Array> CreatePoolArray(V8ResourceImpl* resource, const std::vector<T*>& all)
 {
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::COLSHAPE);
+    v8::Isolate* isolate = resource->GetIsolate();
+    v8::Local<v8::Context> ctx = resource->GetContext();
     v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
 
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
+    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(ctx, i, resource->GetBaseObjectOrNull(all[i]));
 
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
+    jsAll->SetIntegrityLevel(ctx, v8::IntegrityLevel::kFrozen);
     return jsAll;
 }
 
-#ifdef ALT_SERVER_API
-v8::Local<v8::Array> V8ResourceImpl::GetAllConnectionInfos()
+v8::Local<v8::Array> V8ResourceImpl::GetPool(alt::IBaseObject::Type type)
 {
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::CONNECTION_INFO);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
+    PoolCache& pool = pools[type];
+    if(!pool.dirty) return pool.array.Get(isolate);
 
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
+    pool.dirty = false;
+    v8::Local<v8::Array> jsAll = CreatePoolArray(this, ICore::Instance().GetBaseObjects(type));
+    pool.array.Reset(isolate, jsAll);
     return jsAll;
 }
-#endif
 
 #ifdef ALT_CLIENT_API
-v8::Local<v8::Array> V8ResourceImpl::GetAllLocalObjects()
-{
-    if(objectPoolDirty)
-    {
-        objectPoolDirty = false;
-
-        std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::LOCAL_OBJECT);
-        v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-        for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-        objects.Reset(isolate, jsAll);
-        jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-        return jsAll;
-    }
-    return objects.Get(isolate);
-}
-
 v8::Local<v8::Array> V8ResourceImpl::GetAllWeaponObjects()
 {
     if(weaponObjectPoolDirty)
     {
         weaponObjectPoolDirty = false;
 
-        std::vector<ILocalObject*> all = ICore::Instance().GetWeaponObjects();
-        v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-        for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
+        v8::Local<v8::Array> jsAll = CreatePoolArray(this, ICore::Instance().GetWeaponObjects());
         weaponObjects.Reset(isolate, jsAll);
-        jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
         return jsAll;
     }
     return weaponObjects.Get(isolate);
 }
 #endif
 
-v8::Local<v8::Array> V8ResourceImpl::GetAllObjects()
-{
-    std::vector<IBaseObject*> all = ICore::Instance().GetBaseObjects(alt::IBaseObject::Type::OBJECT);
-    v8::Local<v8::Array> jsAll = v8::Array::New(isolate, all.size());
-
-    for(uint32_t i = 0; i < all.size(); ++i) jsAll->Set(GetContext(), i, GetBaseObjectOrNull(all[i]));
-
-    jsAll->SetIntegrityLevel(GetContext(), v8::IntegrityLevel::kFrozen);
-    return jsAll;
-}
-
-std::vector<V8Helpers::EventCallback*> V8ResourceImpl::GetLocalHandlers(const std::string& name)
-{
-    std::vector<V8Helpers::EventCallback*> handlers;
-    auto range = localHandlers.equal_range(name);
-
-    for(auto it = range.first; it != range.second; ++it) handlers.push_back(&it->second);
-
-    return handlers;
-}
-
-std::vector<V8Helpers::EventCallback*> V8ResourceImpl::GetRemoteHandlers(const std::string& name)
-{
-    std::vector<V8Helpers::EventCallback*> handlers;
-    auto range = remoteHandlers.equal_range(name);
-
-    for(auto it = range.first; it != range.second; ++it) handlers.push_back(&it->second);
-
-    return handlers;
-}
-
-std::vector<V8Helpers::EventCallback*> V8ResourceImpl::GetGenericHandlers(bool local)
-{
-    std::vector<V8Helpers::EventCallback*> handlers;
-    if(local)
-        for(auto& it : localGenericHandlers) handlers.push_back(&it);
-    else
-        for(auto& it : remoteGenericHandlers) handlers.push_back(&it);
-    return handlers;
-}
-
 extern V8Class v8Resource;
 v8::Local<v8::Object> V8ResourceImpl::GetOrCreateResourceObject(alt::IResource* resource)
 {
@@ -540,17 +376,24 @@ void V8ResourceImpl::DeleteResourceObject(alt::IResource* resource)
     resourceObjects.erase(resource);
 }
 
-void V8ResourceImpl::InvokeEventHandlers(const alt::CEvent* ev, const std::vector<V8Helpers::EventCallback*>& handlers, std::vector<v8::Local<v8::Value>>& args, bool waitForPromiseResolve)
+void V8ResourceImpl::InvokeEventHandlers(const alt::CEvent* ev, const V8Helpers::EventCallbackSpan& handlers, std::vector<v8::Local<v8::Value>>& args, bool waitForPromiseResolve)
 {
-    for(auto handler : handlers)
+    static const uint32_t profilerId = CProfiler::RegisterName("V8ResourceImpl::InvokeEventHandlers");
+    CProfiler::Sample _(profilerId, true);
+    dispatchDepth++;
+
+    for(size_t i = 0; i < handlers.size(); i++)
     {
+        V8Helpers::EventCallback* handler = handlers[i];
         if(handler->removed) continue;
         int64_t time = GetTime();
+        int64_t start = V8ResourceMetrics::Now();
 
         V8Helpers::TryCatch(
           [&]
           {
-              v8::MaybeLocal<v8::Value> retn = V8Helpers::CallFunctionWithTimeout(handler->fn.Get(isolate), GetContext(), args);
+              const std::string& eventName = handler->eventId == V8Helpers::EventNames::INVALID_ID ? "*" : V8Helpers::EventNames::GetName(handler->eventId);
+              v8::MaybeLocal<v8::Value> retn = V8Helpers::CallFunctionWithTimeout(handler->fn.Get(isolate), GetContext(), args, eventName);
               if(retn.IsEmpty()) return false;
 
               v8::Local<v8::Value> returnValue = retn.ToLocalChecked();
@@ -596,6 +439,7 @@ void V8ResourceImpl::InvokeEventHandlers(const alt::CEvent* ev, const std::vecto
 
               return true;
           });
+        metrics.AddEvent(handler->eventId, V8ResourceMetrics::Now() - start);
 
         if(GetTime() - time > 50 && !waitForPromiseResolve)
         {
@@ -606,8 +450,14 @@ void V8ResourceImpl::InvokeEventHandlers(const alt::CEvent* ev, const std::vecto
                 Log::Warning << "Event handler at " << resource->GetName() << ":" << handler->location.GetFileName() << " was too long " << (GetTime() - time) << "ms" << Log::Endl;
         }
 
-        if(handler->once) handler->removed = true;
+        if(handler->once)
+        {
+            handler->removed = true;
+            handlersRemoved = true;
+        }
     }
+
+    dispatchDepth--;
 }
 
 // Internal script globals
@@ -631,31 +481,17 @@ static void PrintLog(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_CHECK_ARGS_LEN_MIN(1);
 
     V8_ARG_TO_INT32(1, type);
-    std::stringstream stream;
-    for(size_t i = 1; i < info.Length(); i++)
+    Log::Type logType = type == 1 ? Log::WARNING : type == 2 ? Log::ERR : Log::COLORED;
+    if(type < 0 || type > 2 || !Log::IsEnabled(logType)) return;
+
+    std::string message;
+    for(int i = 1; i < info.Length(); i++)
     {
-        std::string arg = *v8::String::Utf8Value(isolate, info[i]);
-        stream << arg;
-        if(i != info.Length() - 1) stream << " ";
-    }
-    switch(type)
-    {
-        case 0:
-        {
-            alt::ICore::Instance().LogColored(stream.str(), resource->GetResource());
-            break;
-        }
-        case 1:
-        {
-            alt::ICore::Instance().LogWarning(stream.str(), resource->GetResource());
-            break;
-        }
-        case 2:
-        {
-            alt::ICore::Instance().LogError(stream.str(), resource->GetResource());
-            break;
-        }
+        v8::String::Utf8Value arg(isolate, info[i]);
+        if(i != 1) message += ' ';
+        if(*arg) message.append(*arg, arg.length());
     }
+    Log::Write(logType, std::move(message), resource->GetResource());
 }
 
 static std::string extraBootstrapFile;
@@ -751,7 +587,7 @@ alt::MValue V8ResourceImpl::FunctionImpl::Call(alt::MValueArgs args) const
     V8Helpers::TryCatch(
       [&]
       {
-          v8::MaybeLocal<v8::Value> _res = V8Helpers::CallFunctionWithTimeout(function.Get(isolate), resource->GetContext(), v8Args);
+          v8::MaybeLocal<v8::Value> _res = V8Helpers::CallFunctionWithTimeout(function.Get(isolate), resource->GetContext(), v8Args, "Exported function");
 
           if(_res.IsEmpty()) return false;
 
@@ -763,3 +599,139 @@ alt::MValue V8ResourceImpl::FunctionImpl::Call(alt::MValueArgs args) const
 
     return res;
 }
+
+void V8ResourceImpl::RunBenchmarks(uint32_t iterations)
+{
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolateScope(isolate);
+    v8::HandleScope handleScope(isolate);
+
+    v8::Local<v8::Context> ctx = GetContext();
+    v8::Context::Scope scope(ctx);
+
+    auto bench = [&](const char* name, const std::function<void()>& fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < iterations; i++)
+        {
+            v8::HandleScope iterationScope(isolate);
+            fn();
+        }
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        Log::Info << "  " << name << ": " << ns / iterations << "ns/op" << Log::Endl;
+    };
+
+    Log::Info << GetResource()->GetName() << " (" << iterations << " iterations):" << Log::Endl;
+
+    // Event dispatch to a single empty handler
+    const std::string eventName = "__jsBenchmark";
+    v8::Local<v8::Function> handler = v8::Function::New(ctx, [](const v8::FunctionCallbackInfo<v8::Value>&) {}).ToLocalChecked();
+    SubscribeLocal(eventName, handler, V8Helpers::SourceLocation::GetCurrent(isolate));
+    bench("Event dispatch",
+          [&]
+          {
+              std::vector<v8::Local<v8::Value>> args = { V8Helpers::JSValue(1) };
+              InvokeEventHandlers(nullptr, GetLocalHandlers(eventName), args);
+          });
+    UnsubscribeLocal(eventName, handler, V8Helpers::SourceLocation::GetCurrent(isolate));
+
+    v8::Local<v8::Object> obj = v8::Object::New(isolate);
+    obj->Set(ctx, V8Helpers::JSValue("id"), V8Helpers::JSValue(1));
+    obj->Set(ctx, V8Helpers::JSValue("name"), V8Helpers::JSValue("benchmark"));
+    obj->Set(ctx, V8Helpers::JSValue("pos"), CreateVector3({ 1, 2, 3 }));
+    bench("V8ToMValue", [&] { V8Helpers::V8ToMValue(obj); });
+    alt::MValue mvalue = V8Helpers::V8ToMValue(obj);
+    bench("MValueToV8", [&] { V8Helpers::MValueToV8(mvalue); });
+
+    v8::Local<v8::Value> vector = CreateVector3({ 1, 2, 3 });
+    bench("V8ToRawBytes", [&] { V8Helpers::V8ToRawBytes(vector); });
+    alt::MValueByteArray rawBytes = V8Helpers::V8ToRawBytes(vector);
+    if(rawBytes) bench("RawBytesToV8", [&] { V8Helpers::RawBytesToV8(rawBytes); });
+
+    bench("CreateVector3", [&] { CreateVector3({ 1, 2, 3 }); });
+    bench("Player.all", [&] { GetAllPlayers(); });
+    bench("Vehicle.all", [&] { GetAllVehicles(); });
+
+    // Separate wheel, so the timers of the resource don't run
+    int64_t time = GetTime();
+    V8TimerWheel wheel(time);
+    bench("Timer create/remove", [&] { wheel.Remove(wheel.Add(isolate, ctx, time, handler, 1000, true, V8Helpers::SourceLocation("benchmark", 0, ctx))); });
+    wheel.Clear();
+    for(uint32_t i = 0; i < 10000; i++) wheel.Add(isolate, ctx, time, handler, 1000 + i, false, V8Helpers::SourceLocation("benchmark", 0, ctx));
+    // The timers run through V8Timer::Update like on a real tick, so they are only due once per interval
+    bench("Timer tick (10000 timers)",
+          [&]
+          {
+              time++;
+              wheel.Update(time, [&](uint32_t, V8Timer& timer) { return timer.Update(time); });
+          });
+    wheel.Clear();
+
+    // Range query through the spatial index against checking every entity
+    alt::ICore& core = alt::ICore::Instance();
+    std::vector<alt::IBaseObject*> worldObjects;
+    for(alt::IBaseObject::Type type : { alt::IBaseObject::Type::PLAYER, alt::IBaseObject::Type::VEHICLE, alt::IBaseObject::Type::PED, alt::IBaseObject::Type::OBJECT })
+    {
+        const std::vector<alt::IBaseObject*>& objects = core.GetBaseObjects(type);
+        worldObjects.insert(worldObjects.end(), objects.begin(), objects.end());
+    }
+    alt::Vector3f center{ 0, 0, 0 };
+    if(!worldObjects.empty()) center = dynamic_cast<alt::IWorldObject*>(worldObjects.front())->GetPosition();
+    const float range = 100.f;
+    Log::Info << "  Range queries over " << worldObjects.size() << " entities:" << Log::Endl;
+
+    CSpatialIndex::Result result;
+    bench("Entities in range (spatial index)",
+          [&]
+          {
+              result.clear();
+              CSpatialIndex::Instance().GetInRange(center, range, std::nullopt, CSpatialIndex::ALL_TYPES, result);
+          });
+    bench("Entities in range (spatial index, first query of a tick)",
+          [&]
+          {
+              result.clear();
+              CSpatialIndex::Instance().Invalidate();
+              CSpatialIndex::Instance().GetInRange(center, range, std::nullopt, CSpatialIndex::ALL_TYPES, result);
+          });
+    bench("Entities in range (linear scan)",
+          [&]
+          {
+              result.clear();
+              for(alt::IBaseObject* object : worldObjects)
+              {
+                  alt::Vector3f pos = dynamic_cast<alt::IWorldObject*>(object)->GetPosition();
+                  float dx = pos[0] - center[0], dy = pos[1] - center[1], dz = pos[2] - center[2];
+                  if(dx * dx + dy * dy + dz * dz <= range * range) result.push_back(object);
+              }
+          });
+}
+
+void V8ResourceImpl::RunBenchmarksCommand(const std::vector<std::string>& args)
+{
+    uint32_t iterations = 100000;
+    if(args.size() > 1)
+    {
+        try
+        {
+            iterations = std::max<uint32_t>((uint32_t)std::stoul(args[1]), 1);
+        }
+        catch(...)
+        {
+            Log::Error << "Invalid iteration count: " << args[1] << Log::Endl;
+            return;
+        }
+    }
+
+#ifdef ALT_SERVER_API
+    auto resources = CNodeScriptRuntime::Instance().GetResources();
+#else
+    auto resources = CV8ScriptRuntime::Instance().GetResources();
+#endif
+    Log::Info << "================ Benchmark info =================" << Log::Endl;
+    for(auto resource : resources)
+    {
+        if(resource->GetResource()->IsStarted()) resource->RunBenchmarks(iterations);
+    }
+    Log::Info << "======================================================" << Log::Endl;
+}
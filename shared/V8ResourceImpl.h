@@ -8,7 +8,8 @@
 #include "cpp-sdk/objects/IBaseObject.h"
 
 #include "V8Entity.h"
-#include "V8Timer.h"
+#include "V8TimerWheel.h"
+#include "V8ResourceMetrics.h"
 
 #include "IRuntimeEventHandler.h"
 #include "V8Helpers.h"
@@ -28,7 +29,7 @@ public:
         v8::Global<v8::Function> function;
     };
 
-    V8ResourceImpl(v8::Isolate* _isolate, alt::IResource* _resource) : isolate(_isolate), resource(_resource) {}
+    V8ResourceImpl(v8::Isolate* _isolate, alt::IResource* _resource) : isolate(_isolate), resource(_resource), timers(GetTime()) {}
 
     bool Start() override;
     bool Stop() override;
@@ -52,37 +53,29 @@ public:
     {
         alt::CEvent::Type type = V8Helpers::EventHandler::GetTypeForEventName(ev);
         if(type != alt::CEvent::Type::NONE) IRuntimeEventHandler::Instance().EventHandlerAdded(type);
-        localHandlers.insert({ ev, V8Helpers::EventCallback{ isolate, cb, std::move(location), once } });
+        uint32_t id = V8Helpers::EventNames::Intern(ev);
+        localHandlers.GetOrCreate(id).Add(isolate, cb, std::move(location), once).eventId = id;
     }
 
     void SubscribeRemote(const std::string& ev, v8::Local<v8::Function> cb, V8Helpers::SourceLocation&& location, bool once = false)
     {
-        remoteHandlers.insert({ ev, V8Helpers::EventCallback{ isolate, cb, std::move(location), once } });
+        uint32_t id = V8Helpers::EventNames::Intern(ev);
+        remoteHandlers.GetOrCreate(id).Add(isolate, cb, std::move(location), once).eventId = id;
     }
 
     void SubscribeGenericLocal(v8::Local<v8::Function> cb, V8Helpers::SourceLocation&& location, bool once = false)
     {
-        localGenericHandlers.push_back(V8Helpers::EventCallback{ isolate, cb, std::move(location), once });
+        localGenericHandlers.Add(isolate, cb, std::move(location), once);
     }
 
     void SubscribeGenericRemote(v8::Local<v8::Function> cb, V8Helpers::SourceLocation&& location, bool once = false)
     {
-        remoteGenericHandlers.push_back(V8Helpers::EventCallback{ isolate, cb, std::move(location), once });
+        remoteGenericHandlers.Add(isolate, cb, std::move(location), once);
     }
 
     void UnsubscribeLocal(const std::string& ev, v8::Local<v8::Function> cb, V8Helpers::SourceLocation&& location)
     {
-        auto range = localHandlers.equal_range(ev);
-        bool anyHandlerRemoved = false;
-
-        for(auto it = range.first; it != range.second; ++it)
-        {
-            if(it->second.fn.Get(isolate)->StrictEquals(cb))
-            {
-                it->second.removed = true;
-                anyHandlerRemoved = true;
-            }
-        }
+        bool anyHandlerRemoved = RemoveHandlers(localHandlers.Get(V8Helpers::EventNames::Find(ev)), cb);
 
         if(!anyHandlerRemoved)
         {
@@ -96,28 +89,17 @@ public:
 
     void UnsubscribeRemote(const std::string& ev, v8::Local<v8::Function> cb)
     {
-        auto range = remoteHandlers.equal_range(ev);
-
-        for(auto it = range.first; it != range.second; ++it)
-        {
-            if(it->second.fn.Get(isolate)->StrictEquals(cb)) it->second.removed = true;
-        }
+        RemoveHandlers(remoteHandlers.Get(V8Helpers::EventNames::Find(ev)), cb);
     }
 
     void UnsubscribeGenericLocal(v8::Local<v8::Function> cb)
     {
-        for(auto& it : localGenericHandlers)
-        {
-            if(it.fn.Get(isolate)->StrictEquals(cb)) it.removed = true;
-        }
+        RemoveHandlers(&localGenericHandlers, cb);
     }
 
     void UnsubscribeGenericRemote(v8::Local<v8::Function> cb)
     {
-        for(auto& it : remoteGenericHandlers)
-        {
-            if(it.fn.Get(isolate)->StrictEquals(cb)) it.removed = true;
-        }
+        RemoveHandlers(&remoteGenericHandlers, cb);
     }
 
     void DispatchStartEvent(bool error)
@@ -206,63 +188,141 @@ public:
 
     uint32_t CreateTimer(v8::Local<v8::Context> context, v8::Local<v8::Function> callback, uint32_t interval, bool once, V8Helpers::SourceLocation&& location)
     {
-        uint32_t id = ++nextTimerId;
-        timers[id] = new V8Timer{ isolate, context, GetTime(), callback, interval, once, std::move(location) };
-
-        return id;
+        return timers.Add(isolate, context, GetTime(), callback, interval, once, std::move(location));
     }
 
     void RemoveTimer(uint32_t id)
     {
-        oldTimers.push_back(id);
+        timers.Remove(id);
     }
 
     bool DoesTimerExist(uint32_t id)
     {
-        return timers.count(id) != 0;
+        return timers.Exists(id);
     }
 
     void TimerBenchmark()
     {
         size_t totalCount = 0, everyTickCount = 0, intervalCount = 0, timeoutCount = 0;
-        totalCount = timers.size();
-        for(auto [id, timer] : timers)
-        {
-            if(timer->GetInterval() == 0 && !timer->IsOnce()) everyTickCount += 1;
-            else if(timer->IsOnce())
-                timeoutCount += 1;
-            else
-                intervalCount += 1;
-        }
+        totalCount = timers.Size();
+        timers.ForEach(
+          [&](uint32_t id, V8Timer& timer)
+          {
+              if(timer.GetInterval() == 0 && !timer.IsOnce()) everyTickCount += 1;
+              else if(timer.IsOnce())
+                  timeoutCount += 1;
+              else
+                  intervalCount += 1;
+          });
 
         Log::Info << GetResource()->GetName() << ": " << totalCount << " running timers (" << everyTickCount << " EveryTick, " << intervalCount << " Interval, " << timeoutCount << " Timeout"
                   << ")" << Log::Endl;
     }
 
+    V8ResourceMetrics& GetMetrics()
+    {
+        return metrics;
+    }
+
+    // Budget in milliseconds for a single event handler, timer or RPC handler call, 0 if unlimited
+    uint32_t GetExecutionTimeout() const
+    {
+        return executionTimeout;
+    }
+
+    // Measures the hot paths of the module (event dispatch, MValue conversion, serialization, timers, etc.) in this resource
+    void RunBenchmarks(uint32_t iterations);
+    // Handles "js-module --bench [iterations]", runs the benchmarks in every started resource
+    static void RunBenchmarksCommand(const std::vector<std::string>& args);
+
     void NotifyPoolUpdate(alt::IBaseObject* ent);
 
-    v8::Local<v8::Array> GetAllPlayers();
-    v8::Local<v8::Array> GetAllVehicles();
-    v8::Local<v8::Array> GetAllBlips();
-    v8::Local<v8::Array> GetAllAudioOutputs();
-    v8::Local<v8::Array> GetAllCheckpoints();
-    v8::Local<v8::Array> GetAllVirtualEntityGroups();
-    v8::Local<v8::Array> GetAllVirtualEntities();
-    v8::Local<v8::Array> GetAllPeds();
-    v8::Local<v8::Array> GetAllMarkers();
-    v8::Local<v8::Array> GetAllColshapes();
+    // Returns the cached frozen array of all objects of the type, it is rebuilt after an object of the type was created or removed
+    v8::Local<v8::Array> GetPool(alt::IBaseObject::Type type);
+    void InvalidatePool(alt::IBaseObject::Type type)
+    {
+        auto it = pools.find(type);
+        if(it != pools.end()) it->second.dirty = true;
+    }
+
+    v8::Local<v8::Array> GetAllPlayers()
+    {
+        return GetPool(alt::IBaseObject::Type::PLAYER);
+    }
+    v8::Local<v8::Array> GetAllVehicles()
+    {
+        return GetPool(alt::IBaseObject::Type::VEHICLE);
+    }
+    v8::Local<v8::Array> GetAllBlips()
+    {
+        return GetPool(alt::IBaseObject::Type::BLIP);
+    }
+    v8::Local<v8::Array> GetAllAudioOutputs()
+    {
+        return GetPool(alt::IBaseObject::Type::AUDIO_OUTPUT);
+    }
+    v8::Local<v8::Array> GetAllCheckpoints()
+    {
+        return GetPool(alt::IBaseObject::Type::CHECKPOINT);
+    }
+    v8::Local<v8::Array> GetAllVirtualEntityGroups()
+    {
+        return GetPool(alt::IBaseObject::Type::VIRTUAL_ENTITY_GROUP);
+    }
+    v8::Local<v8::Array> GetAllVirtualEntities()
+    {
+        return GetPool(alt::IBaseObject::Type::VIRTUAL_ENTITY);
+    }
+    v8::Local<v8::Array> GetAllPeds()
+    {
+        return GetPool(alt::IBaseObject::Type::PED);
+    }
+    v8::Local<v8::Array> GetAllMarkers()
+    {
+        return GetPool(alt::IBaseObject::Type::MARKER);
+    }
+    v8::Local<v8::Array> GetAllColshapes()
+    {
+        return GetPool(alt::IBaseObject::Type::COLSHAPE);
+    }
 #ifdef ALT_SERVER_API
-    v8::Local<v8::Array> GetAllConnectionInfos();
+    v8::Local<v8::Array> GetAllConnectionInfos()
+    {
+        return GetPool(alt::IBaseObject::Type::CONNECTION_INFO);
+    }
 #endif
 #ifdef ALT_CLIENT_API
-    v8::Local<v8::Array> GetAllLocalObjects();
+    v8::Local<v8::Array> GetAllLocalObjects()
+    {
+        return GetPool(alt::IBaseObject::Type::LOCAL_OBJECT);
+    }
     v8::Local<v8::Array> GetAllWeaponObjects();
 #endif
-    v8::Local<v8::Array> GetAllObjects();
+    v8::Local<v8::Array> GetAllObjects()
+    {
+        return GetPool(alt::IBaseObject::Type::OBJECT);
+    }
 
-    std::vector<V8Helpers::EventCallback*> GetLocalHandlers(const std::string& name);
-    std::vector<V8Helpers::EventCallback*> GetRemoteHandlers(const std::string& name);
-    std::vector<V8Helpers::EventCallback*> GetGenericHandlers(bool local);
+    V8Helpers::EventCallbackSpan GetLocalHandlers(const std::string& name)
+    {
+        return localHandlers.Get(V8Helpers::EventNames::Find(name));
+    }
+    V8Helpers::EventCallbackSpan GetLocalHandlers(uint32_t id)
+    {
+        return localHandlers.Get(id);
+    }
+    V8Helpers::EventCallbackSpan GetRemoteHandlers(const std::string& name)
+    {
+        return remoteHandlers.Get(V8Helpers::EventNames::Find(name));
+    }
+    V8Helpers::EventCallbackSpan GetRemoteHandlers(uint32_t id)
+    {
+        return remoteHandlers.Get(id);
+    }
+    V8Helpers::EventCallbackSpan GetGenericHandlers(bool local)
+    {
+        return local ? &localGenericHandlers : &remoteGenericHandlers;
+    }
 
     using NextTickCallback = std::function<void()>;
     void RunOnNextTick(NextTickCallback&& callback)
@@ -351,27 +411,30 @@ protected:
     V8Helpers::CPersistent<v8::Context> context;
 
     std::unordered_map<alt::IBaseObject*, V8Entity*> entities;
-    std::unordered_map<uint32_t, V8Timer*> timers;
+    V8TimerWheel timers;
     // Key = Name, Value = Start time
     std::unordered_map<std::string, std::chrono::high_resolution_clock::time_point> benchmarkTimers;
+    V8ResourceMetrics metrics;
+    uint32_t executionTimeout = 0;
+    // Whether this resource holds a reference on the spatial index
+    bool usesSpatialIndex = false;
+
+    V8Helpers::EventCallbackTable localHandlers;
+    V8Helpers::EventCallbackTable remoteHandlers;
+    V8Helpers::EventCallbackList localGenericHandlers;
+    V8Helpers::EventCallbackList remoteGenericHandlers;
+    // Removed handlers are erased on the next tick that is not inside of a dispatch
+    bool handlersRemoved = false;
+    uint32_t dispatchDepth = 0;
+
+    struct PoolCache
+    {
+        bool dirty = true;
+        V8Helpers::CPersistent<v8::Array> array;
+    };
+    std::unordered_map<alt::IBaseObject::Type, PoolCache> pools;
 
-    std::unordered_multimap<std::string, V8Helpers::EventCallback> localHandlers;
-    std::unordered_multimap<std::string, V8Helpers::EventCallback> remoteHandlers;
-    std::vector<V8Helpers::EventCallback> localGenericHandlers;
-    std::vector<V8Helpers::EventCallback> remoteGenericHandlers;
-
-    uint32_t nextTimerId = 0;
-    std::vector<uint32_t> oldTimers;
-
-    bool playerPoolDirty = true;
-    V8Helpers::CPersistent<v8::Array> players;
-
-    bool vehiclePoolDirty = true;
-    V8Helpers::CPersistent<v8::Array> vehicles;
-
-    bool objectPoolDirty = true;
-    V8Helpers::CPersistent<v8::Array> objects;
-
+    // Weapon objects are local objects, but they are not fetched by type
     bool weaponObjectPoolDirty = true;
     V8Helpers::CPersistent<v8::Array> weaponObjects;
 
@@ -393,5 +456,24 @@ protected:
         return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
-    void InvokeEventHandlers(const alt::CEvent* ev, const std::vector<V8Helpers::EventCallback*>& handlers, std::vector<v8::Local<v8::Value>>& args, bool waitForPromiseResolve = false);
+    bool RemoveHandlers(V8Helpers::EventCallbackList* handlers, v8::Local<v8::Function> cb)
+    {
+        if(!handlers) return false;
+
+        bool anyHandlerRemoved = false;
+        for(size_t i = 0; i < handlers->size(); i++)
+        {
+            V8Helpers::EventCallback* handler = (*handlers)[i];
+            if(handler->fn.Get(isolate)->StrictEquals(cb))
+            {
+                handler->removed = true;
+                anyHandlerRemoved = true;
+            }
+        }
+
+        if(anyHandlerRemoved) handlersRemoved = true;
+        return anyHandlerRemoved;
+    }
+
+    void InvokeEventHandlers(const alt::CEvent* ev, const V8Helpers::EventCallbackSpan& handlers, std::vector<v8::Local<v8::Value>>& args, bool waitForPromiseResolve = false);
 };
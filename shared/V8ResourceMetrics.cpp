@@ -0,0 +1,96 @@
+#include "V8ResourceMetrics.h"
+
+#include <algorithm>
+
+#include "V8Helpers.h"
+
+V8ResourceMetrics::GCStats V8ResourceMetrics::gc;
+v8::Isolate* V8ResourceMetrics::gcIsolate = nullptr;
+
+int64_t V8ResourceMetrics::Histogram::GetPercentile(double p) const
+{
+    if(count == 0) return 0;
+
+    uint64_t target = (uint64_t)(count * p);
+    uint64_t seen = 0;
+    for(uint32_t i = 0; i < CProfiler::BUCKET_COUNT; i++)
+    {
+        seen += buckets[i];
+        if(seen > target) return std::clamp(CProfiler::GetBucketValue(i), min, max);
+    }
+    return max;
+}
+
+v8::Local<v8::Object> V8ResourceMetrics::Histogram::ToObject(v8::Local<v8::Context> ctx) const
+{
+    v8::Local<v8::Object> obj = v8::Object::New(ctx->GetIsolate());
+    obj->Set(ctx, V8Helpers::JSValue("count"), V8Helpers::JSValue((double)count));
+    obj->Set(ctx, V8Helpers::JSValue("total"), V8Helpers::JSValue(total / 1000.0));
+    obj->Set(ctx, V8Helpers::JSValue("avg"), V8Helpers::JSValue(count == 0 ? 0.0 : (double)total / count / 1000.0));
+    obj->Set(ctx, V8Helpers::JSValue("min"), V8Helpers::JSValue(count == 0 ? 0.0 : min / 1000.0));
+    obj->Set(ctx, V8Helpers::JSValue("max"), V8Helpers::JSValue(max / 1000.0));
+    obj->Set(ctx, V8Helpers::JSValue("p50"), V8Helpers::JSValue(GetPercentile(0.5) / 1000.0));
+    obj->Set(ctx, V8Helpers::JSValue("p90"), V8Helpers::JSValue(GetPercentile(0.9) / 1000.0));
+    obj->Set(ctx, V8Helpers::JSValue("p99"), V8Helpers::JSValue(GetPercentile(0.99) / 1000.0));
+    return obj;
+}
+
+v8::Local<v8::Object> V8ResourceMetrics::ToObject(v8::Local<v8::Context> ctx) const
+{
+    v8::Isolate* isolate = ctx->GetIsolate();
+
+    v8::Local<v8::Object> eventsObj = v8::Object::New(isolate);
+    for(auto& [id, histogram] : events)
+    {
+        const std::string& name = id == V8Helpers::EventNames::INVALID_ID ? "*" : V8Helpers::EventNames::GetName(id);
+        eventsObj->Set(ctx, V8Helpers::JSValue(name), histogram.ToObject(ctx));
+    }
+
+    v8::Local<v8::Object> timersObj = v8::Object::New(isolate);
+    timersObj->Set(ctx, V8Helpers::JSValue("execution"), timerExecution.ToObject(ctx));
+    timersObj->Set(ctx, V8Helpers::JSValue("lateness"), timerLateness.ToObject(ctx));
+
+    v8::Local<v8::Object> gcObj = v8::Object::New(isolate);
+    gcObj->Set(ctx, V8Helpers::JSValue("scavenge"), gc.scavenge.ToObject(ctx));
+    gcObj->Set(ctx, V8Helpers::JSValue("markSweep"), gc.markSweep.ToObject(ctx));
+    gcObj->Set(ctx, V8Helpers::JSValue("other"), gc.other.ToObject(ctx));
+
+    v8::Local<v8::Object> rawBytesObj = v8::Object::New(isolate);
+    rawBytesObj->Set(ctx, V8Helpers::JSValue("serialized"), V8Helpers::JSValue((double)rawSerializedBytes));
+    rawBytesObj->Set(ctx, V8Helpers::JSValue("deserialized"), V8Helpers::JSValue((double)rawDeserializedBytes));
+
+    v8::Local<v8::Object> obj = v8::Object::New(isolate);
+    obj->Set(ctx, V8Helpers::JSValue("events"), eventsObj);
+    obj->Set(ctx, V8Helpers::JSValue("timers"), timersObj);
+    obj->Set(ctx, V8Helpers::JSValue("microtasks"), microtasks.ToObject(ctx));
+    obj->Set(ctx, V8Helpers::JSValue("gc"), gcObj);
+    obj->Set(ctx, V8Helpers::JSValue("rawBytes"), rawBytesObj);
+    return obj;
+}
+
+void V8ResourceMetrics::OnGCPrologue(v8::Isolate* isolate, v8::GCType, v8::GCCallbackFlags)
+{
+    if(isolate != gcIsolate) return;
+    gc.start = Now();
+}
+
+void V8ResourceMetrics::OnGCEpilogue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags)
+{
+    if(isolate != gcIsolate) return;
+    int64_t duration = Now() - gc.start;
+    switch(type)
+    {
+        case v8::kGCTypeScavenge:
+        case v8::kGCTypeMinorMarkCompact: gc.scavenge.Add(duration); break;
+        case v8::kGCTypeMarkSweepCompact: gc.markSweep.Add(duration); break;
+        default: gc.other.Add(duration); break;
+    }
+}
+
+void V8ResourceMetrics::RegisterGCCallbacks(v8::Isolate* isolate)
+{
+    if(gcIsolate) return;
+    gcIsolate = isolate;
+    isolate->AddGCPrologueCallback(&OnGCPrologue);
+    isolate->AddGCEpilogueCallback(&OnGCEpilogue);
+}
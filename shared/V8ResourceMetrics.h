@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+#include "v8.h"
+#include "CProfiler.h"
+
+// Runtime metrics of a single resource, only accessed from the thread of the resource.
+// Durations are recorded in microseconds into the same log-linear histograms the profiler uses.
+class V8ResourceMetrics
+{
+public:
+    class Histogram
+    {
+        uint64_t count = 0;
+        int64_t total = 0;
+        int64_t min = std::numeric_limits<int64_t>::max();
+        int64_t max = 0;
+        std::array<uint32_t, CProfiler::BUCKET_COUNT> buckets{};
+
+    public:
+        void Add(int64_t value)
+        {
+            count++;
+            total += value;
+            if(value < min) min = value;
+            if(value > max) max = value;
+            buckets[CProfiler::GetBucket(value)]++;
+        }
+
+        uint64_t GetCount() const
+        {
+            return count;
+        }
+        int64_t GetTotal() const
+        {
+            return total;
+        }
+        int64_t GetPercentile(double p) const;
+
+        // { count, total, avg, min, max, p50, p90, p99 }, times in milliseconds
+        v8::Local<v8::Object> ToObject(v8::Local<v8::Context> ctx) const;
+    };
+
+    // Pauses of the main isolate, on the server they are shared by all resources
+    struct GCStats
+    {
+        Histogram scavenge;
+        Histogram markSweep;
+        Histogram other;
+        int64_t start = 0;
+    };
+
+private:
+    // Key = Interned event name, generic handlers use INVALID_ID
+    std::unordered_map<uint32_t, Histogram> events;
+    uint64_t eventsCount = 0;
+    int64_t eventsTime = 0;
+    Histogram timerExecution;
+    Histogram timerLateness;
+    Histogram microtasks;
+    // Only V8ToRawBytes and RawBytesToV8, the MValue conversions of events don't know their size
+    uint64_t rawSerializedBytes = 0;
+    uint64_t rawDeserializedBytes = 0;
+
+    static GCStats gc;
+    // GC callbacks of other isolates, like the client workers, are ignored
+    static v8::Isolate* gcIsolate;
+
+    static void OnGCPrologue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags);
+    static void OnGCEpilogue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags);
+
+public:
+    static int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void AddEvent(uint32_t eventId, int64_t duration)
+    {
+        events[eventId].Add(duration);
+        eventsCount++;
+        eventsTime += duration;
+    }
+    // Lateness is negative for timers that run every tick
+    void AddTimer(int64_t lateness, int64_t duration)
+    {
+        if(lateness >= 0) timerLateness.Add(lateness);
+        timerExecution.Add(duration);
+    }
+    void AddMicrotasks(int64_t duration)
+    {
+        microtasks.Add(duration);
+    }
+    void AddRawSerializedBytes(size_t size)
+    {
+        rawSerializedBytes += size;
+    }
+    void AddRawDeserializedBytes(size_t size)
+    {
+        rawDeserializedBytes += size;
+    }
+
+    uint64_t GetEventsCount() const
+    {
+        return eventsCount;
+    }
+    int64_t GetEventsTime() const
+    {
+        return eventsTime;
+    }
+    const Histogram& GetTimerExecution() const
+    {
+        return timerExecution;
+    }
+    const Histogram& GetTimerLateness() const
+    {
+        return timerLateness;
+    }
+    uint64_t GetRawSerializedBytes() const
+    {
+        return rawSerializedBytes;
+    }
+    uint64_t GetRawDeserializedBytes() const
+    {
+        return rawDeserializedBytes;
+    }
+
+    void Reset()
+    {
+        *this = V8ResourceMetrics();
+    }
+
+    v8::Local<v8::Object> ToObject(v8::Local<v8::Context> ctx) const;
+
+    static const GCStats& GetGCStats()
+    {
+        return gc;
+    }
+    // Only the first registered isolate is recorded, has to be the main isolate
+    static void RegisterGCCallbacks(v8::Isolate* isolate);
+};
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "V8Helpers.h"
-#include "V8ResourceImpl.h"
 
 class V8Timer
 {
@@ -12,13 +11,20 @@ public:
         // Log::Debug << "Create timer: " << curTime << " " << interval << Log::Endl;
     }
 
+    ~V8Timer()
+    {
+        // CPersistent doesn't reset on destruction
+        context.Reset();
+        callback.Reset();
+    }
+
     bool Update(int64_t curTime)
     {
         if(curTime - lastRun >= interval)
         {
             V8Helpers::TryCatch([&] {
                 std::vector<v8::Local<v8::Value>> args;
-                v8::MaybeLocal<v8::Value> result = V8Helpers::CallFunctionWithTimeout(callback.Get(isolate), context.Get(isolate), args);
+                v8::MaybeLocal<v8::Value> result = V8Helpers::CallFunctionWithTimeout(callback.Get(isolate), context.Get(isolate), args, once ? "setTimeout callback" : "setInterval callback");
                 return !result.IsEmpty();
             });
 
@@ -38,6 +44,10 @@ public:
     {
         return interval;
     }
+    int64_t GetNextRun() const
+    {
+        return lastRun + interval;
+    }
     bool IsOnce()
     {
         return once;
@@ -0,0 +1,194 @@
+#include "V8TimerWheel.h"
+
+#include <algorithm>
+
+V8TimerWheel::V8TimerWheel(int64_t curTime) : current(curTime)
+{
+    nearSlots.fill(INVALID_INDEX);
+    for(auto& level : farSlots) level.fill(INVALID_INDEX);
+}
+
+uint32_t V8TimerWheel::Add(v8::Isolate* isolate,
+                           v8::Local<v8::Context> context,
+                           int64_t curTime,
+                           v8::Local<v8::Function> callback,
+                           uint32_t interval,
+                           bool once,
+                           V8Helpers::SourceLocation&& location)
+{
+    uint32_t index = AllocateEntry();
+    Entry& entry = GetEntry(index);
+    entry.timer.emplace(isolate, context, curTime, callback, interval, once, std::move(location));
+    entry.id = ++nextId;
+    entry.removed = false;
+    ids.insert({ entry.id, index });
+
+    if(interval == 0) everyTick.push_back(index);
+    else
+        Link(index, GetSlot(entry.timer->GetNextRun()));
+
+    return entry.id;
+}
+
+void V8TimerWheel::Remove(uint32_t id)
+{
+    auto it = ids.find(id);
+    if(it == ids.end()) return;
+
+    uint32_t index = it->second;
+    Entry& entry = GetEntry(index);
+    if(entry.removed) return;
+
+    entry.removed = true;
+    if(entry.list) Unlink(index);
+    if(entry.timer->GetInterval() == 0) everyTickDirty = true;
+    removed.push_back(index);
+}
+
+void V8TimerWheel::Clear()
+{
+    pages.clear();
+    capacity = 0;
+    freeEntries.clear();
+    ids.clear();
+    everyTick.clear();
+    everyTickDirty = false;
+    removed.clear();
+    dueQueue.clear();
+    scheduledCount = 0;
+
+    nearSlots.fill(INVALID_INDEX);
+    for(auto& level : farSlots) level.fill(INVALID_INDEX);
+}
+
+uint32_t V8TimerWheel::AllocateEntry()
+{
+    if(!freeEntries.empty())
+    {
+        uint32_t index = freeEntries.back();
+        freeEntries.pop_back();
+        return index;
+    }
+
+    if((capacity & PAGE_MASK) == 0) pages.push_back(std::make_unique<Entry[]>(PAGE_SIZE));
+    return capacity++;
+}
+
+void V8TimerWheel::FlushRemoved()
+{
+    if(removed.empty()) return;
+
+    if(everyTickDirty)
+    {
+        everyTick.erase(std::remove_if(everyTick.begin(), everyTick.end(), [this](uint32_t index) { return GetEntry(index).removed; }), everyTick.end());
+        everyTickDirty = false;
+    }
+
+    for(uint32_t index : removed)
+    {
+        Entry& entry = GetEntry(index);
+        ids.erase(entry.id);
+        entry.timer.reset();
+        freeEntries.push_back(index);
+    }
+    removed.clear();
+}
+
+uint32_t* V8TimerWheel::GetSlot(int64_t due)
+{
+    int64_t delta = due - current;
+    // Already overdue, run it with the next processed slot
+    if(delta < 0) return &nearSlots[current & NEAR_MASK];
+    if(delta < NEAR_SIZE) return &nearSlots[due & NEAR_MASK];
+
+    for(int level = 0; level < FAR_LEVELS; level++)
+    {
+        int shift = NEAR_BITS + (level + 1) * FAR_BITS;
+        if(delta < (int64_t(1) << shift)) return &farSlots[level][(due >> (shift - FAR_BITS)) & FAR_MASK];
+    }
+
+    // Too far away for the wheel (~18 hours), park it in the furthest slot until it gets cascaded again
+    constexpr int maxShift = NEAR_BITS + FAR_LEVELS * FAR_BITS;
+    int64_t clamped = current + (int64_t(1) << maxShift) - 1;
+    return &farSlots[FAR_LEVELS - 1][(clamped >> (maxShift - FAR_BITS)) & FAR_MASK];
+}
+
+void V8TimerWheel::Link(uint32_t index, uint32_t* list)
+{
+    Entry& entry = GetEntry(index);
+    entry.list = list;
+    entry.prev = INVALID_INDEX;
+    entry.next = *list;
+    if(*list != INVALID_INDEX) GetEntry(*list).prev = index;
+    *list = index;
+    scheduledCount++;
+}
+
+void V8TimerWheel::Unlink(uint32_t index)
+{
+    Entry& entry = GetEntry(index);
+    if(entry.prev != INVALID_INDEX) GetEntry(entry.prev).next = entry.next;
+    else
+        *entry.list = entry.next;
+    if(entry.next != INVALID_INDEX) GetEntry(entry.next).prev = entry.prev;
+
+    entry.list = nullptr;
+    entry.prev = INVALID_INDEX;
+    entry.next = INVALID_INDEX;
+    scheduledCount--;
+}
+
+void V8TimerWheel::Cascade(uint32_t* list)
+{
+    uint32_t index = *list;
+    *list = INVALID_INDEX;
+
+    while(index != INVALID_INDEX)
+    {
+        Entry& entry = GetEntry(index);
+        uint32_t next = entry.next;
+        scheduledCount--;
+        Link(index, GetSlot(entry.timer->GetNextRun()));
+        index = next;
+    }
+}
+
+void V8TimerWheel::Advance(int64_t curTime, std::vector<uint32_t>& queue)
+{
+    // Nothing is scheduled, so there is nothing to cascade either
+    if(scheduledCount == 0)
+    {
+        if(curTime >= current) current = curTime + 1;
+        return;
+    }
+
+    while(current <= curTime)
+    {
+        uint32_t index = current & NEAR_MASK;
+        if(index == 0)
+        {
+            for(int level = 0; level < FAR_LEVELS; level++)
+            {
+                uint32_t slot = (current >> (NEAR_BITS + level * FAR_BITS)) & FAR_MASK;
+                Cascade(&farSlots[level][slot]);
+                if(slot != 0) break;
+            }
+        }
+
+        uint32_t it = nearSlots[index];
+        nearSlots[index] = INVALID_INDEX;
+        while(it != INVALID_INDEX)
+        {
+            Entry& entry = GetEntry(it);
+            uint32_t next = entry.next;
+            entry.list = nullptr;
+            entry.prev = INVALID_INDEX;
+            entry.next = INVALID_INDEX;
+            scheduledCount--;
+            queue.push_back(it);
+            it = next;
+        }
+
+        current++;
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "V8Timer.h"
+
+// Hierarchical timing wheel for the resource timers, a tick only touches the timers
+// that are due instead of scanning every timer the resource has created.
+// Timers are owned by a paged slab, so pointers to them stay valid while timers
+// are created or removed from inside a timer callback.
+class V8TimerWheel
+{
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    // Level 0 has a resolution of 1ms and covers 256ms, every further level covers 64 times more
+    static constexpr int NEAR_BITS = 8;
+    static constexpr int FAR_BITS = 6;
+    static constexpr int FAR_LEVELS = 3;
+    static constexpr uint32_t NEAR_SIZE = 1 << NEAR_BITS;
+    static constexpr uint32_t NEAR_MASK = NEAR_SIZE - 1;
+    static constexpr uint32_t FAR_SIZE = 1 << FAR_BITS;
+    static constexpr uint32_t FAR_MASK = FAR_SIZE - 1;
+
+    static constexpr int PAGE_BITS = 8;
+    static constexpr uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+    static constexpr uint32_t PAGE_MASK = PAGE_SIZE - 1;
+
+    struct Entry
+    {
+        std::optional<V8Timer> timer;
+        uint32_t id = 0;
+        uint32_t prev = INVALID_INDEX;
+        uint32_t next = INVALID_INDEX;
+        // Head of the slot list this entry is currently linked into
+        uint32_t* list = nullptr;
+        bool removed = true;
+    };
+
+public:
+    V8TimerWheel(int64_t curTime);
+
+    V8TimerWheel(const V8TimerWheel&) = delete;
+    V8TimerWheel& operator=(const V8TimerWheel&) = delete;
+
+    uint32_t Add(v8::Isolate* isolate,
+                 v8::Local<v8::Context> context,
+                 int64_t curTime,
+                 v8::Local<v8::Function> callback,
+                 uint32_t interval,
+                 bool once,
+                 V8Helpers::SourceLocation&& location);
+
+    // The timer is not executed anymore, but it keeps existing until the next update
+    void Remove(uint32_t id);
+
+    bool Exists(uint32_t id) const
+    {
+        return ids.count(id) != 0;
+    }
+
+    size_t Size() const
+    {
+        return ids.size();
+    }
+
+    void Clear();
+
+    // Calls fn(id, timer) for every timer that is due at curTime,
+    // if fn returns false the timer is removed, otherwise it is scheduled again
+    template<typename Func>
+    void Update(int64_t curTime, Func&& fn)
+    {
+        if(depth == 0) FlushRemoved();
+        depth++;
+
+        // Take over the reusable queue, so a nested update can't invalidate it
+        std::vector<uint32_t> queue = std::move(dueQueue);
+        queue.insert(queue.end(), everyTick.begin(), everyTick.end());
+        Advance(curTime, queue);
+
+        for(uint32_t index : queue)
+        {
+            Entry& entry = GetEntry(index);
+            if(entry.removed) continue;
+
+            if(!fn(entry.id, *entry.timer)) Remove(entry.id);
+            else if(!entry.removed && entry.timer->GetInterval() != 0)
+                Link(index, GetSlot(entry.timer->GetNextRun()));
+        }
+
+        queue.clear();
+        dueQueue = std::move(queue);
+        depth--;
+    }
+
+    template<typename Func>
+    void ForEach(Func&& fn)
+    {
+        for(auto& [id, index] : ids) fn(id, *GetEntry(index).timer);
+    }
+
+private:
+    std::vector<std::unique_ptr<Entry[]>> pages;
+    uint32_t capacity = 0;
+    std::vector<uint32_t> freeEntries;
+
+    std::unordered_map<uint32_t, uint32_t> ids;
+    uint32_t nextId = 0;
+
+    std::array<uint32_t, NEAR_SIZE> nearSlots;
+    std::array<std::array<uint32_t, FAR_SIZE>, FAR_LEVELS> farSlots;
+    // Timers with an interval of 0 run every tick, so they are kept out of the wheel
+    std::vector<uint32_t> everyTick;
+    bool everyTickDirty = false;
+
+    // Time of the next slot that has not been processed yet
+    int64_t current;
+    size_t scheduledCount = 0;
+
+    std::vector<uint32_t> removed;
+    std::vector<uint32_t> dueQueue;
+    uint32_t depth = 0;
+
+    Entry& GetEntry(uint32_t index) const
+    {
+        return pages[index >> PAGE_BITS][index & PAGE_MASK];
+    }
+
+    uint32_t AllocateEntry();
+    void FlushRemoved();
+
+    uint32_t* GetSlot(int64_t due);
+    void Link(uint32_t index, uint32_t* list);
+    void Unlink(uint32_t index);
+    void Cascade(uint32_t* list);
+    void Advance(int64_t curTime, std::vector<uint32_t>& queue);
+};
@@ -0,0 +1,78 @@
+#include "V8Watchdog.h"
+
+#include <algorithm>
+
+V8Watchdog::Scope::Scope(v8::Isolate* _isolate, uint32_t timeout) : isolate(_isolate)
+{
+    if(timeout == 0) return;
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    active = true;
+    Instance().Add(this);
+}
+
+V8Watchdog::Scope::~Scope()
+{
+    Finish();
+}
+
+void V8Watchdog::Scope::Finish()
+{
+    if(!active) return;
+    active = false;
+    bool outerTimedOut = Instance().Remove(this);
+
+    // Termination is only requested while the scope is registered, after removing it there is no new request.
+    // The call might have returned before the termination took effect, so it is always cancelled,
+    // unless an outer call of the same isolate timed out too and still has to be unwound.
+    if(timedOut && !outerTimedOut) isolate->CancelTerminateExecution();
+}
+
+void V8Watchdog::Add(Scope* scope)
+{
+    std::scoped_lock lock(mutex);
+    if(!running && !stopping)
+    {
+        running = true;
+        thread = std::thread(&V8Watchdog::Run, this);
+    }
+    scopes.push_back(scope);
+}
+
+bool V8Watchdog::Remove(Scope* scope)
+{
+    std::scoped_lock lock(mutex);
+    // Scopes are nested, so the scope is almost always the last one
+    auto it = std::find(scopes.rbegin(), scopes.rend(), scope);
+    if(it != scopes.rend()) scopes.erase(std::next(it).base());
+
+    return std::any_of(scopes.begin(), scopes.end(), [&](Scope* other) { return other->isolate == scope->isolate && other->timedOut; });
+}
+
+void V8Watchdog::Run()
+{
+    std::unique_lock lock(mutex);
+    while(!stopping)
+    {
+        condition.wait_for(lock, CHECK_INTERVAL);
+
+        auto now = std::chrono::steady_clock::now();
+        for(Scope* scope : scopes)
+        {
+            if(scope->timedOut || now < scope->deadline) continue;
+            scope->timedOut = true;
+            // Unwinds all JS frames of the isolate, until the timed out call is left and cancels the termination
+            scope->isolate->TerminateExecution();
+        }
+    }
+}
+
+void V8Watchdog::Shutdown()
+{
+    {
+        std::scoped_lock lock(mutex);
+        if(!running) return;
+        stopping = true;
+    }
+    condition.notify_one();
+    thread.join();
+}
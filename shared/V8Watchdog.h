@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "v8.h"
+
+// Terminates script calls that run longer than their execution budget, so a runaway script can't hang the tick.
+// A single thread watches the calls of all isolates (including workers), calls register a Scope while they run.
+class V8Watchdog
+{
+    // How often the thread checks the running calls, this is the precision of the budget
+    static constexpr auto CHECK_INTERVAL = std::chrono::milliseconds(10);
+
+public:
+    class Scope
+    {
+        friend class V8Watchdog;
+
+        v8::Isolate* isolate;
+        std::chrono::steady_clock::time_point deadline;
+        bool active = false;
+        bool timedOut = false;
+
+    public:
+        // A timeout of 0 disables the watchdog for the call
+        Scope(v8::Isolate* isolate, uint32_t timeout);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        // Only valid after Finish, the pending termination of a timed out call is cancelled by Finish
+        bool HasTimedOut() const
+        {
+            return timedOut;
+        }
+        void Finish();
+    };
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<Scope*> scopes;
+    std::thread thread;
+    bool running = false;
+    bool stopping = false;
+
+    std::atomic<uint32_t> defaultTimeout = 5000;
+    std::atomic<uint32_t> workerTimeout = 0;
+
+    void Run();
+    void Add(Scope* scope);
+    // Returns whether another call of the same isolate timed out
+    bool Remove(Scope* scope);
+
+public:
+    static V8Watchdog& Instance()
+    {
+        // Never destroyed, the thread is stopped by Shutdown when the runtime is disposed
+        static V8Watchdog* instance = new V8Watchdog();
+        return *instance;
+    }
+
+    // Budget in milliseconds of resources that don't set their own one, 0 disables the watchdog
+    uint32_t GetDefaultTimeout() const
+    {
+        return defaultTimeout;
+    }
+    void SetDefaultTimeout(uint32_t timeout)
+    {
+        defaultTimeout = timeout;
+    }
+
+    // Budget in milliseconds of worker calls, workers don't use the budget of their resource. 0 (default) disables it
+    uint32_t GetWorkerTimeout() const
+    {
+        return workerTimeout;
+    }
+    void SetWorkerTimeout(uint32_t timeout)
+    {
+        workerTimeout = timeout;
+    }
+
+    void Shutdown();
+};
@@ -3,6 +3,7 @@
 #include "../V8Helpers.h"
 #include "../V8ResourceImpl.h"
 #include "../V8Module.h"
+#include "../CSpatialIndex.h"
 
 static void HashCb(const v8::FunctionCallbackInfo<v8::Value>& info)
 {
@@ -375,16 +376,16 @@ static void GetEventListeners(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_GET_ISOLATE_CONTEXT_RESOURCE();
     V8_CHECK_ARGS_LEN(1);
 
-    std::vector<V8Helpers::EventCallback*> handlers;
+    V8Helpers::EventCallbackSpan handlers;
 
     if(info[0]->IsNull())
     {
-        handlers = std::move(resource->GetGenericHandlers(true));
+        handlers = resource->GetGenericHandlers(true);
     }
     else
     {
         V8_ARG_TO_STRING(1, eventName);
-        handlers = std::move(resource->GetLocalHandlers(eventName));
+        handlers = resource->GetLocalHandlers(eventName);
     }
 
     auto array = v8::Array::New(isolate, handlers.size());
@@ -401,16 +402,16 @@ static void GetRemoteEventListeners(const v8::FunctionCallbackInfo<v8::Value>& i
     V8_GET_ISOLATE_CONTEXT_RESOURCE();
     V8_CHECK_ARGS_LEN(1);
 
-    std::vector<V8Helpers::EventCallback*> handlers;
+    V8Helpers::EventCallbackSpan handlers;
 
     if(info[0]->IsNull())
     {
-        handlers = std::move(resource->GetGenericHandlers(false));
+        handlers = resource->GetGenericHandlers(false);
     }
     else
     {
         V8_ARG_TO_STRING(1, eventName);
-        handlers = std::move(resource->GetRemoteHandlers(eventName));
+        handlers = resource->GetRemoteHandlers(eventName);
     }
 
     auto array = v8::Array::New(isolate, handlers.size());
@@ -465,6 +466,126 @@ static void GetNetTime(const v8::FunctionCallbackInfo<v8::Value>& info)
     V8_RETURN_UINT(netTime);
 }
 
+// Undefined or null dimension means all dimensions
+static bool GetSpatialDimension(const v8::FunctionCallbackInfo<v8::Value>& info, v8::Local<v8::Context> ctx, int idx, std::optional<int32_t>& dimension)
+{
+    if(info.Length() < idx || info[idx - 1]->IsNullOrUndefined()) return true;
+
+    int32_t val;
+    if(!V8Helpers::SafeToInt32(info[idx - 1], ctx, val)) return false;
+    dimension = val;
+    return true;
+}
+
+// Bit mask of the allowed base object types, 1 << type
+static bool GetSpatialAllowedTypes(const v8::FunctionCallbackInfo<v8::Value>& info, v8::Local<v8::Context> ctx, int idx, uint64_t& allowedTypes)
+{
+    allowedTypes = CSpatialIndex::ALL_TYPES;
+    if(info.Length() < idx || info[idx - 1]->IsNullOrUndefined()) return true;
+
+    double val;
+    // Values outside of the uint64_t range can't be cast
+    if(!V8Helpers::SafeToNumber(info[idx - 1], ctx, val) || !(val >= 0 && val < 18446744073709551616.0)) return false;
+    allowedTypes = (uint64_t)val;
+    return true;
+}
+
+static v8::Local<v8::Array> SpatialResultToArray(V8ResourceImpl* resource, const CSpatialIndex::Result& result)
+{
+    v8::Isolate* isolate = resource->GetIsolate();
+    v8::Local<v8::Context> ctx = resource->GetContext();
+
+    v8::Local<v8::Array> arr = v8::Array::New(isolate, (int)result.size());
+    for(uint32_t i = 0; i < result.size(); i++) arr->Set(ctx, i, resource->GetBaseObjectOrNull(result[i]));
+    return arr;
+}
+
+static void GetEntitiesInRange(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN_MIN_MAX(2, 4);
+
+    V8_ARG_TO_VECTOR3(1, pos);
+    V8_ARG_TO_NUMBER(2, range);
+    std::optional<int32_t> dimension;
+    V8_CHECK(GetSpatialDimension(info, ctx, 3, dimension), "Failed to convert argument 3 to int32");
+    uint64_t allowedTypes;
+    V8_CHECK(GetSpatialAllowedTypes(info, ctx, 4, allowedTypes), "Failed to convert argument 4 to number");
+
+    CSpatialIndex::Result result;
+    CSpatialIndex::Instance().GetInRange(pos, (float)range, dimension, allowedTypes, result);
+    V8_RETURN(SpatialResultToArray(resource, result));
+}
+
+static void GetEntitiesInBox(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN_MIN_MAX(2, 4);
+
+    V8_ARG_TO_VECTOR3(1, min);
+    V8_ARG_TO_VECTOR3(2, max);
+    std::optional<int32_t> dimension;
+    V8_CHECK(GetSpatialDimension(info, ctx, 3, dimension), "Failed to convert argument 3 to int32");
+    uint64_t allowedTypes;
+    V8_CHECK(GetSpatialAllowedTypes(info, ctx, 4, allowedTypes), "Failed to convert argument 4 to number");
+
+    CSpatialIndex::Result result;
+    CSpatialIndex::Instance().GetInBox(min, max, dimension, allowedTypes, result);
+    V8_RETURN(SpatialResultToArray(resource, result));
+}
+
+static void GetClosestEntities(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN_MIN_MAX(2, 5);
+
+    V8_ARG_TO_VECTOR3(1, pos);
+    V8_ARG_TO_NUMBER(2, range);
+    std::optional<int32_t> dimension;
+    V8_CHECK(GetSpatialDimension(info, ctx, 3, dimension), "Failed to convert argument 3 to int32");
+    uint32_t limit = std::numeric_limits<uint32_t>::max();
+    if(info.Length() >= 4 && !info[3]->IsNullOrUndefined())
+    {
+        V8_ARG_TO_INT32(4, limitVal);
+        V8_CHECK(limitVal >= 0, "Limit has to be positive");
+        limit = (uint32_t)limitVal;
+    }
+    uint64_t allowedTypes;
+    V8_CHECK(GetSpatialAllowedTypes(info, ctx, 5, allowedTypes), "Failed to convert argument 5 to number");
+
+    CSpatialIndex::Result result;
+    CSpatialIndex::Instance().GetClosest(pos, (float)range, dimension, limit, allowedTypes, result);
+    V8_RETURN(SpatialResultToArray(resource, result));
+}
+
+static void GetEntitiesInDimension(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN_MIN_MAX(1, 2);
+
+    V8_ARG_TO_INT32(1, dimension);
+    uint64_t allowedTypes;
+    V8_CHECK(GetSpatialAllowedTypes(info, ctx, 2, allowedTypes), "Failed to convert argument 2 to number");
+
+    CSpatialIndex::Result result;
+    CSpatialIndex::Instance().GetInDimension(dimension, allowedTypes, result);
+    V8_RETURN(SpatialResultToArray(resource, result));
+}
+
+static void GetResourceMetrics(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+
+    V8_RETURN(resource->GetMetrics().ToObject(ctx));
+}
+
+static void ResetResourceMetrics(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+
+    resource->GetMetrics().Reset();
+}
+
 extern V8Class v8BaseObject, v8WorldObject, v8Entity, v8File, v8RGBA, v8Vector2, v8Vector3, v8Quaternion, v8Blip, v8AreaBlip, v8RadiusBlip, v8PointBlip, v8Resource, v8Utils;
 
 extern V8Module
@@ -521,6 +642,13 @@ extern V8Module
                    V8Helpers::RegisterFunc(exports, "getVoiceConnectionState", &GetVoiceConnectionState);
                    V8Helpers::RegisterFunc(exports, "getNetTime", &GetNetTime);
 
+                   V8Helpers::RegisterFunc(exports, "getEntitiesInRange", &GetEntitiesInRange);
+                   V8Helpers::RegisterFunc(exports, "getEntitiesInBox", &GetEntitiesInBox);
+                   V8Helpers::RegisterFunc(exports, "getClosestEntities", &GetClosestEntities);
+                   V8Helpers::RegisterFunc(exports, "getEntitiesInDimension", &GetEntitiesInDimension);
+                   V8Helpers::RegisterFunc(exports, "getResourceMetrics", &GetResourceMetrics);
+                   V8Helpers::RegisterFunc(exports, "resetResourceMetrics", &ResetResourceMetrics);
+
                    V8_OBJECT_SET_STRING(exports, "version", alt::ICore::Instance().GetVersion());
                    V8_OBJECT_SET_STRING(exports, "branch", alt::ICore::Instance().GetBranch());
                    // V8_OBJECT_SET_RAW_STRING(exports, "sdkVersion", ALT_SDK_VERSION);
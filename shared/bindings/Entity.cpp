@@ -4,7 +4,10 @@
 #include "../V8ResourceImpl.h"
 #include "../V8Class.h"
 #include "../V8Entity.h"
+#include "../CSpatialIndex.h"
 #include "cpp-sdk/objects/IPlayer.h"
+#include "cpp-sdk/objects/IVehicle.h"
+#include "cpp-sdk/objects/IPed.h"
 
 using namespace alt;
 
@@ -192,6 +195,7 @@ static void PositionSetter(v8::Local<v8::String>, v8::Local<v8::Value> val, cons
         return;
     }
     _this->SetPosition(vector);
+    CSpatialIndex::Instance().Update(_this);
 }
 
 static void RotationGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
@@ -250,6 +254,182 @@ static void StaticAllGetter(v8::Local<v8::String>, const v8::PropertyCallbackInf
     V8_RETURN(arr);
 }
 
+// Columns of the bulk state, fields that don't apply to an entity are written as NaN
+enum class BulkStateField : uint8_t
+{
+    ID,
+    POS,
+    ROT,
+    DIMENSION,
+    MODEL,
+    VELOCITY,
+    HEALTH,
+    MAX_HEALTH,
+    ARMOUR,
+    IS_DEAD
+};
+
+static const std::unordered_map<std::string, std::pair<BulkStateField, uint32_t>> bulkStateFields = {
+    { "id", { BulkStateField::ID, 1 } },
+    { "pos", { BulkStateField::POS, 3 } },
+    { "rot", { BulkStateField::ROT, 3 } },
+    { "dimension", { BulkStateField::DIMENSION, 1 } },
+    { "model", { BulkStateField::MODEL, 1 } },
+    { "velocity", { BulkStateField::VELOCITY, 3 } },
+    { "health", { BulkStateField::HEALTH, 1 } },
+    { "maxHealth", { BulkStateField::MAX_HEALTH, 1 } },
+    { "armour", { BulkStateField::ARMOUR, 1 } },
+    { "isDead", { BulkStateField::IS_DEAD, 1 } },
+};
+
+extern V8Class v8BaseObject;
+
+// Casts of the entity, done once per entity instead of once per field
+struct BulkStateEntity
+{
+    alt::IEntity* ent;
+    alt::IPlayer* player;
+    alt::IPed* ped;
+    alt::IVehicle* vehicle;
+};
+
+template<typename T>
+static void WriteBulkStateField(const BulkStateEntity& entity, BulkStateField field, T* out)
+{
+    constexpr T NaN = std::numeric_limits<T>::quiet_NaN();
+    alt::IEntity* ent = entity.ent;
+    alt::IPlayer* player = entity.player;
+    alt::IPed* ped = entity.ped;
+    alt::IVehicle* vehicle = entity.vehicle;
+
+    switch(field)
+    {
+        case BulkStateField::ID: out[0] = (T)ent->GetID(); break;
+        case BulkStateField::POS:
+        {
+            alt::Vector3f pos = ent->GetPosition();
+            for(int i = 0; i < 3; i++) out[i] = (T)pos[i];
+            break;
+        }
+        case BulkStateField::ROT:
+        {
+            alt::Vector3f rot = ent->GetRotation();
+            for(int i = 0; i < 3; i++) out[i] = (T)rot[i];
+            break;
+        }
+        case BulkStateField::DIMENSION: out[0] = (T)ent->GetDimension(); break;
+        case BulkStateField::MODEL: out[0] = (T)ent->GetModel(); break;
+        case BulkStateField::VELOCITY:
+        {
+            if(!vehicle)
+            {
+                out[0] = out[1] = out[2] = NaN;
+                break;
+            }
+            alt::Vector3f velocity = vehicle->GetVelocity();
+            for(int i = 0; i < 3; i++) out[i] = (T)velocity[i];
+            break;
+        }
+        case BulkStateField::HEALTH: out[0] = player ? (T)player->GetHealth() : ped ? (T)ped->GetHealth() : NaN; break;
+        case BulkStateField::MAX_HEALTH: out[0] = player ? (T)player->GetMaxHealth() : ped ? (T)ped->GetMaxHealth() : NaN; break;
+        case BulkStateField::ARMOUR: out[0] = player ? (T)player->GetArmour() : ped ? (T)ped->GetArmour() : NaN; break;
+        case BulkStateField::IS_DEAD: out[0] = player ? (T)player->IsDead() : NaN; break;
+    }
+}
+
+template<typename T>
+static void WriteBulkState(const std::vector<alt::IEntity*>& entities, const std::vector<std::pair<BulkStateField, uint32_t>>& fields, uint32_t stride, T* out)
+{
+    constexpr T NaN = std::numeric_limits<T>::quiet_NaN();
+
+    for(size_t i = 0; i < entities.size(); i++)
+    {
+        T* row = out + i * stride;
+
+        alt::IEntity* ent = entities[i];
+        if(!ent)
+        {
+            std::fill(row, row + stride, NaN);
+            continue;
+        }
+
+        BulkStateEntity entity{ ent, dynamic_cast<alt::IPlayer*>(ent) };
+        entity.ped = entity.player ? nullptr : dynamic_cast<alt::IPed*>(ent);
+        entity.vehicle = entity.player || entity.ped ? nullptr : dynamic_cast<alt::IVehicle*>(ent);
+
+        for(auto& [field, size] : fields)
+        {
+            WriteBulkStateField(entity, field, row);
+            row += size;
+        }
+    }
+}
+
+// Writes the given fields of every entity into the typed array in one call, one row per entity
+static void StaticGetBulkState(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_CHECK_ARGS_LEN2(2, 3);
+
+    V8_ARG_TO_ARRAY(1, fieldNames);
+    V8_CHECK(info[1]->IsFloat32Array() || info[1]->IsFloat64Array(), "Expected Float32Array or Float64Array as second argument");
+    v8::Local<v8::TypedArray> out = info[1].As<v8::TypedArray>();
+
+    std::vector<std::pair<BulkStateField, uint32_t>> fields;
+    uint32_t stride = 0;
+    for(uint32_t i = 0; i < fieldNames->Length(); i++)
+    {
+        V8_TO_STRING(fieldNames->Get(ctx, i).ToLocalChecked(), name);
+        auto it = bulkStateFields.find(name);
+        V8_CHECK(it != bulkStateFields.end(), "Invalid bulk state field: " + name);
+        fields.push_back(it->second);
+        stride += it->second.second;
+    }
+
+    // Reading the array can run getters of the script, which may resize it, destroy entities or detach the
+    // output buffer. So all values are read first and only resolved once no more script code can run.
+    std::vector<v8::Local<v8::Value>> values;
+    if(info.Length() == 3)
+    {
+        V8_ARG_TO_ARRAY(3, entitiesArr);
+        uint32_t length = entitiesArr->Length();
+        values.reserve(length);
+        for(uint32_t i = 0; i < length; i++)
+        {
+            v8::Local<v8::Value> val;
+            if(!entitiesArr->Get(ctx, i).ToLocal(&val)) return;
+            values.push_back(val);
+        }
+    }
+
+    std::vector<alt::IEntity*> entities;
+    if(info.Length() == 3)
+    {
+        v8::Local<v8::FunctionTemplate> baseObjectTpl = v8BaseObject.GetTemplate(isolate);
+        entities.reserve(values.size());
+        for(v8::Local<v8::Value> val : values)
+        {
+            // Brand check, other objects with internal fields are no V8Entity
+            V8Entity* v8Entity = val->IsObject() && baseObjectTpl->HasInstance(val) ? V8Entity::Get(val.As<v8::Object>()) : nullptr;
+            entities.push_back(v8Entity ? dynamic_cast<alt::IEntity*>(v8Entity->GetHandle()) : nullptr);
+        }
+    }
+    else
+    {
+        entities = alt::ICore::Instance().GetEntities();
+    }
+
+    size_t size = entities.size() * stride;
+    V8_CHECK(out->Length() >= size, "Output array is too small, it needs " + std::to_string(size) + " elements");
+
+    uint8_t* data = (uint8_t*)out->Buffer()->GetBackingStore()->Data() + out->ByteOffset();
+    if(out->IsFloat32Array()) WriteBulkState(entities, fields, stride, (float*)data);
+    else
+        WriteBulkState(entities, fields, stride, (double*)data);
+
+    V8_RETURN_UINT((uint32_t)entities.size());
+}
+
 extern V8Class v8WorldObject;
 extern V8Class v8Entity("Entity",
                         v8WorldObject,
@@ -258,6 +438,7 @@ extern V8Class v8Entity("Entity",
                             v8::Isolate* isolate = v8::Isolate::GetCurrent();
 
                             V8Helpers::SetStaticAccessor(isolate, tpl, "all", StaticAllGetter);
+                            V8Helpers::SetStaticMethod(isolate, tpl, "getBulkState", StaticGetBulkState);
 
                             V8Helpers::SetAccessor<IEntity, IPlayer*, &IEntity::GetNetworkOwner>(isolate, tpl, "netOwner");
 
@@ -0,0 +1,11 @@
+/// <reference path="../../bindings.d.ts"/>
+// clang-format off
+// Entity JS bindings
+
+// Bulk state of the entities of a class, defaults to all entities of that class
+for (const entityClass of [alt.Player, alt.Vehicle, alt.Ped]) {
+    if (!entityClass) continue;
+    entityClass.getBulkState = function(fields, out, entities = entityClass.all) {
+        return alt.Entity.getBulkState(fields, out, entities);
+    };
+}
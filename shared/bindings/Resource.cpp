@@ -1,6 +1,9 @@
 #include "../V8Class.h"
 #include "../V8Helpers.h"
 #include "../V8ResourceImpl.h"
+#ifdef ALT_SERVER_API
+    #include "CNodeResourceImpl.h"
+#endif
 
 extern V8Class v8Resource;
 
@@ -41,6 +44,20 @@ static void ExportsGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<
     V8_GET_ISOLATE_CONTEXT();
     V8_GET_THIS_INTERNAL_FIELD_EXTERNAL(1, resource, alt::IResource);
     V8_CHECK(resource, "Invalid resource");
+
+#ifdef ALT_SERVER_API
+    // All JS resources share the isolate, so their exported functions can be called without converting to MValues
+    if(resource->GetType() == "js")
+    {
+        CNodeResourceImpl* jsResource = static_cast<CNodeResourceImpl*>(resource->GetImpl());
+        if(jsResource && jsResource->IsEnvStarted())
+        {
+            V8_RETURN(jsResource->GetDirectExports(ctx));
+            return;
+        }
+    }
+#endif
+
     V8_RETURN(V8Helpers::MValueToV8(resource->GetExports()));
 }
 
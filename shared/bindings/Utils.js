@@ -204,7 +204,9 @@ function assertNotNaN(val, message = "Expected number") {
     alt.Utils.assert(!isNaN(val), message)
 }
 
-function getClosestEntityFromPool(getEntities, options = {}) {
+// Uses the spatial index to only check the entities around pos,
+// filter decides which of them belong to the requested pool
+function getClosestEntityInRange(filter, options = {}) {
     const {
         pos,
         range = Infinity,
@@ -212,10 +214,15 @@ function getClosestEntityFromPool(getEntities, options = {}) {
     assertVector3(pos, "Expected Vector3 as pos option");
     assertNotNaN(range, "Expected a number as range option");
 
+    const min = new alt.Vector3(pos.x - range, pos.y - range, pos.z - range);
+    const max = new alt.Vector3(pos.x + range, pos.y + range, pos.z + range);
+
     let closestEntity = null;
     let closestDistance = Infinity;
 
-    for (const entity of getEntities()) {
+    for (const entity of alt.getEntitiesInBox(min, max)) {
+        if (!filter(entity)) continue;
+
         const distance = pos.distanceTo(entity.pos);
         if (distance > range || distance > closestDistance) continue;
 
@@ -784,9 +791,9 @@ if (alt.isClient && !alt.isWorker) {
     alt.Utils.registerPedheadshot3Base64 = registerPedheadshotBase64.bind(null, native.registerPedheadshotHires);
     alt.Utils.registerPedheadshotTransparentBase64 = registerPedheadshotBase64.bind(null, native.registerPedheadshotTransparent);
 
-    const getClosestEntity = (getEntities) => (options = {}) => {
-        return getClosestEntityFromPool(
-            getEntities,
+    const getClosestEntity = (filter) => (options = {}) => {
+        return getClosestEntityInRange(
+            filter,
             {
                 pos: options.pos ?? alt.Player.local.pos,
                 ...options
@@ -794,19 +801,20 @@ if (alt.isClient && !alt.isWorker) {
         );
     };
 
-    alt.Utils.getClosestVehicle = getClosestEntity(() => alt.Vehicle.streamedIn);
-    alt.Utils.getClosestPlayer = getClosestEntity(() => alt.Player.streamedIn);
-    alt.Utils.getClosestWorldObject = getClosestEntity(() => alt.LocalObject.allWorld);
-    alt.Utils.getClosestVirtualEntity = getClosestEntity(() => alt.VirtualEntity.streamedIn);
+    // Streamed in entities are the ones that are spawned in the game
+    alt.Utils.getClosestVehicle = getClosestEntity((entity) => entity instanceof alt.Vehicle && !(entity instanceof alt.LocalVehicle) && entity.isSpawned);
+    alt.Utils.getClosestPlayer = getClosestEntity((entity) => entity instanceof alt.Player && entity !== alt.Player.local && entity.isSpawned);
+    alt.Utils.getClosestWorldObject = getClosestEntity((entity) => entity instanceof alt.LocalObject && entity.isWorldObject);
+    alt.Utils.getClosestVirtualEntity = getClosestEntity((entity) => entity instanceof alt.VirtualEntity && entity.isStreamedIn);
 
     // TODO: change it to .streamedIn when serverside api will be added
-    alt.Utils.getClosestObject = getClosestEntity(() => alt.LocalObject.all);
+    alt.Utils.getClosestObject = getClosestEntity((entity) => entity instanceof alt.LocalObject);
 }
 // Server only
 else {
-    const getClosestEntity = (getEntities) =>
-        getClosestEntityFromPool.bind(null, getEntities);
+    const getClosestEntity = (filter) =>
+        getClosestEntityInRange.bind(null, filter);
 
-    alt.Utils.getClosestVehicle = getClosestEntity(() => alt.Vehicle.all);
-    alt.Utils.getClosestPlayer = getClosestEntity(() => alt.Player.all);
+    alt.Utils.getClosestVehicle = getClosestEntity((entity) => entity instanceof alt.Vehicle);
+    alt.Utils.getClosestPlayer = getClosestEntity((entity) => entity instanceof alt.Player);
 }
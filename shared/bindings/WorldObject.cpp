@@ -4,9 +4,44 @@
 #include "../V8ResourceImpl.h"
 #include "../V8Class.h"
 #include "../V8Entity.h"
+#include "../CSpatialIndex.h"
 
 using namespace alt;
 
+static void PositionGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE_CONTEXT_RESOURCE();
+    V8_GET_THIS_BASE_OBJECT(object, IWorldObject);
+    V8_RETURN_VECTOR3(object->GetPosition());
+}
+
+static void PositionSetter(v8::Local<v8::String>, v8::Local<v8::Value> val, const v8::PropertyCallbackInfo<void>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_GET_THIS_BASE_OBJECT(object, IWorldObject);
+    V8_TO_VECTOR3(val, pos);
+
+    object->SetPosition(pos);
+    CSpatialIndex::Instance().Update(object);
+}
+
+static void DimensionGetter(v8::Local<v8::String>, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+    V8_GET_ISOLATE();
+    V8_GET_THIS_BASE_OBJECT(object, IWorldObject);
+    V8_RETURN_INT(object->GetDimension());
+}
+
+static void DimensionSetter(v8::Local<v8::String>, v8::Local<v8::Value> val, const v8::PropertyCallbackInfo<void>& info)
+{
+    V8_GET_ISOLATE_CONTEXT();
+    V8_GET_THIS_BASE_OBJECT(object, IWorldObject);
+    V8_TO_INT32(val, dimension);
+
+    object->SetDimension(dimension);
+    CSpatialIndex::Instance().Update(object);
+}
+
 extern V8Class v8BaseObject;
 extern V8Class v8WorldObject("WorldObject",
                              v8BaseObject,
@@ -14,6 +49,6 @@ extern V8Class v8WorldObject("WorldObject",
                              {
                                  v8::Isolate* isolate = v8::Isolate::GetCurrent();
 
-                                 V8Helpers::SetAccessor<IWorldObject, Position, &IWorldObject::GetPosition, &IWorldObject::SetPosition>(isolate, tpl, "pos");
-                                 V8Helpers::SetAccessor<IWorldObject, int32_t, &IWorldObject::GetDimension, &IWorldObject::SetDimension>(isolate, tpl, "dimension");
+                                 V8Helpers::SetAccessor(isolate, tpl, "pos", &PositionGetter, &PositionSetter);
+                                 V8Helpers::SetAccessor(isolate, tpl, "dimension", &DimensionGetter, &DimensionSetter);
                              });
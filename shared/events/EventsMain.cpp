@@ -43,11 +43,14 @@ V8_EVENT_HANDLER colshapeEvent(
   EventType::COLSHAPE_EVENT,
   [](V8ResourceImpl* resource, const alt::CEvent* e)
   {
+      static uint32_t enterId = V8Helpers::EventNames::Intern("entityEnterColshape");
+      static uint32_t leaveId = V8Helpers::EventNames::Intern("entityLeaveColshape");
+
       auto ev = static_cast<const alt::CColShapeEvent*>(e);
 
-      if(ev->GetState()) return resource->GetLocalHandlers("entityEnterColshape");
+      if(ev->GetState()) return resource->GetLocalHandlers(enterId);
       else
-          return resource->GetLocalHandlers("entityLeaveColshape");
+          return resource->GetLocalHandlers(leaveId);
   },
   [](V8ResourceImpl* resource, const alt::CEvent* e, std::vector<v8::Local<v8::Value>>& args)
   {
@@ -3,13 +3,136 @@
 #include "Bindings.h"
 #include "CProfiler.h"
 
-alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+// Byte arrays of at least this size are passed to JS without copying them when enabled,
+// the array buffer references the data of the MValue and keeps it alive.
+// Smaller buffers are copied, as that is cheaper than the external backing store.
+static constexpr size_t SHARED_BYTE_ARRAY_MIN_SIZE = 16 * 1024;
+// Opt-in, the MValue data is shared with every other receiver and JS can write to it
+static std::atomic_bool zeroCopyByteArrays = false;
+
+// Byte array MValues that are currently referenced by array buffers, keyed by their data pointer,
+// so an array buffer that is passed back from JS can reuse the MValue instead of copying it again
+struct SharedByteArray
 {
-    CProfiler::Sample _("V8Helpers::V8ToMValue", true);
-    alt::ICore& core = alt::ICore::Instance();
+    std::weak_ptr<const alt::IMValueByteArray> mvalue;
+    uint32_t refs = 0;
+};
+static std::mutex sharedByteArraysMutex;
+static std::unordered_map<const void*, SharedByteArray> sharedByteArrays;
 
-    v8::Isolate* isolate = v8::Isolate::GetCurrent();
-    v8::Local<v8::Context> ctx = isolate->GetEnteredOrMicrotaskContext();
+static v8::Local<v8::ArrayBuffer> ByteArrayToV8(v8::Isolate* isolate, const alt::MValueByteArrayConst& buffer)
+{
+    size_t size = buffer->GetSize();
+#if !defined(V8_SANDBOXED_POINTERS) && !defined(V8_ENABLE_SANDBOX)
+    // Memory outside of the sandbox can't be used as a backing store
+    if(zeroCopyByteArrays && size >= SHARED_BYTE_ARRAY_MIN_SIZE)
+    {
+        void* data = const_cast<uint8_t*>(buffer->GetData());
+        {
+            std::scoped_lock lock(sharedByteArraysMutex);
+            SharedByteArray& shared = sharedByteArrays[data];
+            shared.mvalue = buffer;
+            shared.refs++;
+        }
+
+        // The deleter can be called from any thread
+        auto deleter = [](void* data, size_t, void* deleterData)
+        {
+            {
+                std::scoped_lock lock(sharedByteArraysMutex);
+                auto it = sharedByteArrays.find(data);
+                if(it != sharedByteArrays.end() && --it->second.refs == 0) sharedByteArrays.erase(it);
+            }
+            delete static_cast<alt::MValueByteArrayConst*>(deleterData);
+        };
+        std::unique_ptr<v8::BackingStore> backingStore = v8::ArrayBuffer::NewBackingStore(data, size, deleter, new alt::MValueByteArrayConst(buffer));
+        return v8::ArrayBuffer::New(isolate, std::move(backingStore));
+    }
+#endif
+
+    v8::Local<v8::ArrayBuffer> v8Buffer = v8::ArrayBuffer::New(isolate, size);
+    std::memcpy(v8Buffer->GetBackingStore()->Data(), buffer->GetData(), size);
+    return v8Buffer;
+}
+
+static alt::MValue V8ToByteArray(const uint8_t* data, size_t size)
+{
+    if(zeroCopyByteArrays && size >= SHARED_BYTE_ARRAY_MIN_SIZE)
+    {
+        std::scoped_lock lock(sharedByteArraysMutex);
+        auto it = sharedByteArrays.find(data);
+        if(it != sharedByteArrays.end())
+        {
+            // Only if the whole buffer is passed, byte array MValues are never modified by the SDK
+            alt::MValueByteArrayConst mvalue = it->second.mvalue.lock();
+            if(mvalue && mvalue->GetSize() == size) return std::const_pointer_cast<alt::IMValueByteArray>(mvalue);
+        }
+    }
+    return alt::ICore::Instance().CreateMValueByteArray(data, size);
+}
+
+void V8Helpers::SetZeroCopyByteArrays(bool enabled)
+{
+    zeroCopyByteArrays = enabled;
+}
+
+extern V8Class v8Vector3, v8Vector2, v8RGBA, v8BaseObject;
+
+namespace
+{
+    // Looked up once per conversion instead of once per nested value
+    struct V8ToMValueState
+    {
+        v8::Isolate* isolate;
+        v8::Local<v8::Context> ctx;
+        alt::ICore& core;
+
+        // Only loaded when the first object with internal fields is converted
+        bool templatesLoaded = false;
+        v8::Local<v8::FunctionTemplate> vector3;
+        v8::Local<v8::FunctionTemplate> vector2;
+        v8::Local<v8::FunctionTemplate> rgba;
+        v8::Local<v8::FunctionTemplate> baseObject;
+
+        void LoadTemplates()
+        {
+            vector3 = v8Vector3.GetTemplate(isolate);
+            vector2 = v8Vector2.GetTemplate(isolate);
+            rgba = v8RGBA.GetTemplate(isolate);
+            baseObject = v8BaseObject.GetTemplate(isolate);
+            templatesLoaded = true;
+        }
+
+        // Brand check against the class template, unlike InstanceOf this doesn't walk the prototype chain in JS
+        static bool HasInstance(v8::Local<v8::FunctionTemplate> tpl, v8::Local<v8::Object> obj)
+        {
+            return !tpl.IsEmpty() && tpl->HasInstance(obj);
+        }
+    };
+}  // namespace
+
+// Avoids the intermediate buffer of v8::String::Utf8Value
+static std::string KeyToString(v8::Isolate* isolate, v8::Local<v8::Value> key)
+{
+    if(!key->IsString()) return *v8::String::Utf8Value(isolate, key);
+
+    v8::Local<v8::String> str = key.As<v8::String>();
+    std::string result(str->Utf8Length(isolate), '\0');
+    str->WriteUtf8(isolate, result.data(), (int)result.size(), nullptr, v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+    return result;
+}
+
+static alt::MValue ConvertToMValue(V8ToMValueState& state, v8::Local<v8::Value> val, bool allowFunction)
+{
+    v8::Isolate* isolate = state.isolate;
+    v8::Local<v8::Context> ctx = state.ctx;
+    alt::ICore& core = state.core;
 
     if(val.IsEmpty()) return core.CreateMValueNone();
 
@@ -19,9 +142,9 @@ alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
 
     if(val->IsBoolean()) return core.CreateMValueBool(val->BooleanValue(isolate));
 
-    if(val->IsInt32()) return core.CreateMValueInt(val->Int32Value(ctx).ToChecked());
+    if(val->IsInt32()) return core.CreateMValueInt(val.As<v8::Int32>()->Value());
 
-    if(val->IsUint32()) return core.CreateMValueUInt(val->Uint32Value(ctx).ToChecked());
+    if(val->IsUint32()) return core.CreateMValueUInt(val.As<v8::Uint32>()->Value());
 
     if(val->IsBigInt())
     {
@@ -32,22 +155,23 @@ alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
             return core.CreateMValueInt(val.As<v8::BigInt>()->Int64Value());
     }
 
-    if(val->IsNumber()) return core.CreateMValueDouble(val->NumberValue(ctx).ToChecked());
+    if(val->IsNumber()) return core.CreateMValueDouble(val.As<v8::Number>()->Value());
 
-    if(val->IsString()) return core.CreateMValueString(*v8::String::Utf8Value(isolate, val));
+    if(val->IsString()) return core.CreateMValueString(KeyToString(isolate, val));
 
     if(val->IsObject())
     {
         if(val->IsArray())
         {
             v8::Local<v8::Array> v8Arr = val.As<v8::Array>();
-            alt::MValueList list = core.CreateMValueList(v8Arr->Length());
+            uint32_t length = v8Arr->Length();
+            alt::MValueList list = core.CreateMValueList(length);
 
-            for(uint32_t i = 0; i < v8Arr->Length(); ++i)
+            for(uint32_t i = 0; i < length; ++i)
             {
                 v8::Local<v8::Value> value;
                 if(!v8Arr->Get(ctx, i).ToLocal(&value)) continue;
-                list->Set(i, V8ToMValue(value, allowFunction));
+                list->Set(i, ConvertToMValue(state, value, allowFunction));
             }
 
             return list;
@@ -66,14 +190,14 @@ alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
         else if(val->IsArrayBuffer())
         {
             auto v8Buffer = val.As<v8::ArrayBuffer>()->GetBackingStore();
-            return core.CreateMValueByteArray((uint8_t*)v8Buffer->Data(), v8Buffer->ByteLength());
+            return V8ToByteArray((uint8_t*)v8Buffer->Data(), v8Buffer->ByteLength());
         }
         else if(val->IsTypedArray())
         {
             v8::Local<v8::TypedArray> typedArray = val.As<v8::TypedArray>();
             if(!typedArray->HasBuffer()) return core.CreateMValueNone();
             v8::Local<v8::ArrayBuffer> v8Buffer = typedArray->Buffer();
-            return core.CreateMValueByteArray((uint8_t*)((uintptr_t)v8Buffer->GetBackingStore()->Data() + typedArray->ByteOffset()), typedArray->ByteLength());
+            return V8ToByteArray((uint8_t*)((uintptr_t)v8Buffer->GetBackingStore()->Data() + typedArray->ByteOffset()), typedArray->ByteLength());
         }
         else if(val->IsMap())
         {
@@ -81,7 +205,7 @@ alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
             v8::Local<v8::Array> mapArr = map->AsArray();
             uint32_t size = mapArr->Length();
 
-            alt::MValueDict dict = alt::ICore::Instance().CreateMValueDict();
+            alt::MValueDict dict = core.CreateMValueDict();
             for(uint32_t i = 0; i < size; i += 2)
             {
                 auto maybeKey = mapArr->Get(ctx, i);
@@ -91,82 +215,98 @@ alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
 
                 if(!maybeKey.ToLocal(&key)) continue;
                 if(!maybeValue.ToLocal(&value)) continue;
-                std::string keyString = V8Helpers::Stringify(ctx, val);
+                std::string keyString = V8Helpers::Stringify(ctx, key);
                 if(keyString.empty()) continue;
-                dict->Set(keyString, V8ToMValue(value, false));
+                dict->Set(keyString, ConvertToMValue(state, value, false));
             }
             return dict;
         }
         else
         {
-            V8ResourceImpl* resource = V8ResourceImpl::Get(ctx);
             v8::Local<v8::Object> v8Obj = val.As<v8::Object>();
 
-            // if (v8Obj->InstanceOf(ctx, v8Vector3->JSValue(isolate, ctx)).ToChecked())
-            if(resource->IsVector3(v8Obj))
+            // Instances of the module classes always have internal fields, plain objects never do
+            if(v8Obj->InternalFieldCount() != 0)
             {
-                v8::Local<v8::Value> x, y, z;
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_XKey(isolate)).ToLocal(&x), "Failed to convert Vector3 to MValue", core.CreateMValueNil());
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_YKey(isolate)).ToLocal(&y), "Failed to convert Vector3 to MValue", core.CreateMValueNil());
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_ZKey(isolate)).ToLocal(&z), "Failed to convert Vector3 to MValue", core.CreateMValueNil());
+                if(!state.templatesLoaded) state.LoadTemplates();
 
-                return core.CreateMValueVector3(alt::Vector3f{ x.As<v8::Number>()->Value(), y.As<v8::Number>()->Value(), z.As<v8::Number>()->Value() });
-            }
-            else if(resource->IsVector2(v8Obj))
-            {
-                v8::Local<v8::Value> x, y;
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_XKey(isolate)).ToLocal(&x), "Failed to convert Vector2 to MValue", core.CreateMValueNil());
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_YKey(isolate)).ToLocal(&y), "Failed to convert Vector2 to MValue", core.CreateMValueNil());
-
-                return core.CreateMValueVector2(alt::Vector2f{ x.As<v8::Number>()->Value(), y.As<v8::Number>()->Value() });
-            }
-            else if(resource->IsRGBA(v8Obj))
-            {
-                v8::Local<v8::Value> r, g, b, a;
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_RKey(isolate)).ToLocal(&r), "Failed to convert RGBA to MValue", core.CreateMValueNil());
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_GKey(isolate)).ToLocal(&g), "Failed to convert RGBA to MValue", core.CreateMValueNil());
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_BKey(isolate)).ToLocal(&b), "Failed to convert RGBA to MValue", core.CreateMValueNil());
-                V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_AKey(isolate)).ToLocal(&a), "Failed to convert RGBA to MValue", core.CreateMValueNil());
-
-                return core.CreateMValueRGBA(
-                  alt::RGBA{ (uint8_t)r.As<v8::Number>()->Value(), (uint8_t)g.As<v8::Number>()->Value(), (uint8_t)b.As<v8::Number>()->Value(), (uint8_t)a.As<v8::Number>()->Value() });
-            }
-            else if(resource->IsBaseObject(v8Obj))
-            {
-                V8Entity* ent = V8Entity::Get(v8Obj);
+                if(state.HasInstance(state.vector3, v8Obj))
+                {
+                    v8::Local<v8::Value> x, y, z;
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_XKey(isolate)).ToLocal(&x), "Failed to convert Vector3 to MValue", core.CreateMValueNil());
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_YKey(isolate)).ToLocal(&y), "Failed to convert Vector3 to MValue", core.CreateMValueNil());
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_ZKey(isolate)).ToLocal(&z), "Failed to convert Vector3 to MValue", core.CreateMValueNil());
 
-                V8_CHECK_RETN(ent, "Unable to convert base object to MValue because it was destroyed and is now invalid", core.CreateMValueNil());
-                return core.CreateMValueBaseObject(ent->GetHandle());
-            }
-            else
-            {
-                alt::MValueDict dict = core.CreateMValueDict();
-                v8::Local<v8::Array> keys;
+                    return core.CreateMValueVector3(alt::Vector3f{ x.As<v8::Number>()->Value(), y.As<v8::Number>()->Value(), z.As<v8::Number>()->Value() });
+                }
+                else if(state.HasInstance(state.vector2, v8Obj))
+                {
+                    v8::Local<v8::Value> x, y;
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_XKey(isolate)).ToLocal(&x), "Failed to convert Vector2 to MValue", core.CreateMValueNil());
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::Vector3_YKey(isolate)).ToLocal(&y), "Failed to convert Vector2 to MValue", core.CreateMValueNil());
 
-                V8_CHECK_RETN(v8Obj->GetOwnPropertyNames(ctx).ToLocal(&keys), "Failed to convert object to MValue", core.CreateMValueNil());
-                for(uint32_t i = 0; i < keys->Length(); ++i)
+                    return core.CreateMValueVector2(alt::Vector2f{ x.As<v8::Number>()->Value(), y.As<v8::Number>()->Value() });
+                }
+                else if(state.HasInstance(state.rgba, v8Obj))
                 {
-                    v8::Local<v8::Value> v8Key;
-                    V8_CHECK_RETN(keys->Get(ctx, i).ToLocal(&v8Key), "Failed to convert object to MValue", core.CreateMValueNil());
-                    v8::Local<v8::Value> value;
-                    V8_CHECK_RETN(v8Obj->Get(ctx, v8Key).ToLocal(&value), "Failed to convert object to MValue", core.CreateMValueNil());
-
-                    if(value->IsUndefined()) continue;
-                    std::string key = *v8::String::Utf8Value(isolate, v8Key);
-                    dict->Set(key, V8ToMValue(value, allowFunction));
+                    v8::Local<v8::Value> r, g, b, a;
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_RKey(isolate)).ToLocal(&r), "Failed to convert RGBA to MValue", core.CreateMValueNil());
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_GKey(isolate)).ToLocal(&g), "Failed to convert RGBA to MValue", core.CreateMValueNil());
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_BKey(isolate)).ToLocal(&b), "Failed to convert RGBA to MValue", core.CreateMValueNil());
+                    V8_CHECK_RETN(v8Obj->Get(ctx, V8Helpers::RGBA_AKey(isolate)).ToLocal(&a), "Failed to convert RGBA to MValue", core.CreateMValueNil());
+
+                    return core.CreateMValueRGBA(
+                      alt::RGBA{ (uint8_t)r.As<v8::Number>()->Value(), (uint8_t)g.As<v8::Number>()->Value(), (uint8_t)b.As<v8::Number>()->Value(), (uint8_t)a.As<v8::Number>()->Value() });
                 }
+                else if(state.HasInstance(state.baseObject, v8Obj))
+                {
+                    V8Entity* ent = V8Entity::Get(v8Obj);
+
+                    V8_CHECK_RETN(ent, "Unable to convert base object to MValue because it was destroyed and is now invalid", core.CreateMValueNil());
+                    return core.CreateMValueBaseObject(ent->GetHandle());
+                }
+            }
+
+            alt::MValueDict dict = core.CreateMValueDict();
+            v8::Local<v8::Array> keys;
+
+            V8_CHECK_RETN(v8Obj->GetPropertyNames(ctx, v8::KeyCollectionMode::kOwnOnly, (v8::PropertyFilter)(v8::ONLY_ENUMERABLE | v8::SKIP_SYMBOLS), v8::IndexFilter::kIncludeIndices, v8::KeyConversionMode::kConvertToString).ToLocal(&keys),
+                          "Failed to convert object to MValue",
+                          core.CreateMValueNil());
+            uint32_t length = keys->Length();
+            for(uint32_t i = 0; i < length; ++i)
+            {
+                v8::Local<v8::Value> v8Key;
+                V8_CHECK_RETN(keys->Get(ctx, i).ToLocal(&v8Key), "Failed to convert object to MValue", core.CreateMValueNil());
+                v8::Local<v8::Value> value;
+                V8_CHECK_RETN(v8Obj->Get(ctx, v8Key).ToLocal(&value), "Failed to convert object to MValue", core.CreateMValueNil());
 
-                return dict;
+                if(value->IsUndefined()) continue;
+                dict->Set(KeyToString(isolate, v8Key), ConvertToMValue(state, value, allowFunction));
             }
+
+            return dict;
         }
     }
 
     return core.CreateMValueNone();
 }
 
+alt::MValue V8Helpers::V8ToMValue(v8::Local<v8::Value> val, bool allowFunction)
+{
+    // Only the outermost value is sampled, nested values are part of its sample
+    static const uint32_t profilerId = CProfiler::RegisterName("V8Helpers::V8ToMValue");
+    CProfiler::Sample _(profilerId, true);
+
+    v8::Isolate* isolate = v8::Isolate::GetCurrent();
+    V8ToMValueState state{ isolate, isolate->GetEnteredOrMicrotaskContext(), alt::ICore::Instance() };
+    return ConvertToMValue(state, val, allowFunction);
+}
+
 v8::Local<v8::Value> V8Helpers::MValueToV8(alt::MValueConst val)
 {
-    CProfiler::Sample _("V8Helpers::MValueToV8", true);
+    static const uint32_t profilerId = CProfiler::RegisterName("V8Helpers::MValueToV8");
+    CProfiler::Sample _(profilerId, true);
     static constexpr int64_t JS_MAX_SAFE_INTEGER = 9007199254740991;
     static constexpr int64_t JS_MIN_SAFE_INTEGER = JS_MAX_SAFE_INTEGER * -1;
 
@@ -241,9 +381,7 @@ v8::Local<v8::Value> V8Helpers::MValueToV8(alt::MValueConst val)
             v8::MaybeLocal<v8::Value> jsVal = RawBytesToV8(buffer);
             if(!jsVal.IsEmpty()) return jsVal.ToLocalChecked();
 
-            v8::Local<v8::ArrayBuffer> v8Buffer = v8::ArrayBuffer::New(isolate, buffer->GetSize());
-            std::memcpy(v8Buffer->GetBackingStore()->Data(), buffer->GetData(), buffer->GetSize());
-            return v8Buffer;
+            return ByteArrayToV8(isolate, buffer);
         }
         default: Log::Warning << "V8Helpers::MValueToV8 Unknown MValue type " << (int)val->GetType() << Log::Endl;
     }
@@ -292,7 +430,8 @@ static inline RawValueType GetValueType(v8::Local<v8::Context> ctx, v8::Local<v8
 
 static inline bool WriteRawValue(v8::Local<v8::Context> ctx, v8::ValueSerializer& serializer, RawValueType type, v8::Local<v8::Object> val)
 {
-    CProfiler::Sample _("WriteRawValue", true);
+    static const uint32_t profilerId = CProfiler::RegisterName("WriteRawValue");
+    CProfiler::Sample _(profilerId, true);
     serializer.WriteRawBytes(&type, sizeof(uint8_t));
     switch(type)
     {
@@ -365,7 +504,8 @@ static inline bool WriteRawValue(v8::Local<v8::Context> ctx, v8::ValueSerializer
 
 static inline v8::MaybeLocal<v8::Object> ReadRawValue(v8::Local<v8::Context> ctx, v8::ValueDeserializer& deserializer)
 {
-    CProfiler::Sample _("ReadRawValue", true);
+    static const uint32_t profilerId = CProfiler::RegisterName("ReadRawValue");
+    CProfiler::Sample _(profilerId, true);
     v8::Isolate* isolate = ctx->GetIsolate();
     V8ResourceImpl* resource = V8ResourceImpl::Get(ctx);
 
@@ -439,12 +579,74 @@ static inline v8::MaybeLocal<v8::Object> ReadRawValue(v8::Local<v8::Context> ctx
     return v8::MaybeLocal<v8::Object>();
 }
 
+// Output buffer of the raw serializer, reused by all calls on the thread instead of allocating a new one per value.
+// The serialized data is copied into the MValue, so the buffer is free again once the call returns.
+class RawBytesArena
+{
+    // Above this capacity the buffer is released again when recent payloads are much smaller
+    static constexpr size_t MAX_IDLE_CAPACITY = 64 * 1024;
+
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    // Moving average of the recent payload sizes, used to pre-size the buffer
+    size_t averageSize = 0;
+    bool inUse = false;
+
+public:
+    ~RawBytesArena()
+    {
+        free(data);
+    }
+
+    static RawBytesArena& Get()
+    {
+        static thread_local RawBytesArena arena;
+        return arena;
+    }
+
+    // Returns false if the buffer is already used by an outer call (e.g. a getter that emits a raw event)
+    bool Acquire()
+    {
+        if(inUse) return false;
+        inUse = true;
+        return true;
+    }
+    void Release(size_t size)
+    {
+        inUse = false;
+        averageSize = averageSize - averageSize / 8 + size / 8;
+        if(capacity > MAX_IDLE_CAPACITY && capacity > averageSize * 4)
+        {
+            free(data);
+            data = nullptr;
+            capacity = 0;
+        }
+    }
+
+    void* Reserve(size_t size, size_t* actualSize)
+    {
+        if(size > capacity)
+        {
+            size_t newCapacity = std::max({ size, capacity * 2, averageSize * 2 });
+            void* newData = realloc(data, newCapacity);
+            if(!newData) return nullptr;
+            data = (uint8_t*)newData;
+            capacity = newCapacity;
+        }
+        *actualSize = capacity;
+        return data;
+    }
+};
+
 class WriteDelegate : public v8::ValueSerializer::Delegate
 {
-    v8::ValueSerializer* serializer;
+    v8::Local<v8::Context> ctx;
+    v8::ValueSerializer* serializer = nullptr;
+    // Nullptr if the buffer is allocated by V8 instead
+    RawBytesArena* arena;
 
 public:
-    WriteDelegate() {}
+    WriteDelegate(v8::Local<v8::Context> _ctx, RawBytesArena* _arena) : ctx(_ctx), arena(_arena) {}
 
     void SetSerializer(v8::ValueSerializer* _serializer)
     {
@@ -453,12 +655,11 @@ public:
 
     void ThrowDataCloneError(v8::Local<v8::String> message) override
     {
-        V8Helpers::Throw(v8::Isolate::GetCurrent(), V8Helpers::CppValue(message));
+        V8Helpers::Throw(ctx->GetIsolate(), V8Helpers::CppValue(message));
     }
 
     v8::Maybe<bool> WriteHostObject(v8::Isolate* isolate, v8::Local<v8::Object> object) override
     {
-        v8::Local<v8::Context> ctx = isolate->GetEnteredOrMicrotaskContext();
         RawValueType type = GetValueType(ctx, object);
         if(type == RawValueType::INVALID) return v8::Nothing<bool>();
         bool result = WriteRawValue(ctx, *serializer, type, object);
@@ -469,14 +670,26 @@ public:
         }
         return v8::Just(true);
     }
+
+    void* ReallocateBufferMemory(void* oldBuffer, size_t size, size_t* actualSize) override
+    {
+        if(!arena) return v8::ValueSerializer::Delegate::ReallocateBufferMemory(oldBuffer, size, actualSize);
+        return arena->Reserve(size, actualSize);
+    }
+
+    void FreeBufferMemory(void* buffer) override
+    {
+        if(!arena) v8::ValueSerializer::Delegate::FreeBufferMemory(buffer);
+    }
 };
 
 class ReadDelegate : public v8::ValueDeserializer::Delegate
 {
-    v8::ValueDeserializer* deserializer;
+    v8::Local<v8::Context> ctx;
+    v8::ValueDeserializer* deserializer = nullptr;
 
 public:
-    ReadDelegate() {}
+    ReadDelegate(v8::Local<v8::Context> _ctx) : ctx(_ctx) {}
 
     void SetDeserializer(v8::ValueDeserializer* _deserializer)
     {
@@ -485,16 +698,26 @@ public:
 
     v8::MaybeLocal<v8::Object> ReadHostObject(v8::Isolate* isolate) override
     {
-        v8::Local<v8::Context> ctx = isolate->GetEnteredOrMicrotaskContext();
         return ReadRawValue(ctx, *deserializer);
     }
 };
 
+// Checks for the magic bytes behind the serializer header (version tag + varint version),
+// so byte arrays that are no raw JS values don't need a deserializer
+static bool HasRawBytesHeader(const uint8_t* data, size_t size)
+{
+    if(size < 2 || data[0] != 0xFF) return false;
+    size_t offset = 1;
+    while(offset < size && (data[offset] & 0x80)) offset++;
+    offset++;
+    return size >= offset + sizeof(magicBytes) && memcmp(data + offset, magicBytes, sizeof(magicBytes)) == 0;
+}
+
 // Converts a JS value to a MValue byte array
 alt::MValueByteArray V8Helpers::V8ToRawBytes(v8::Local<v8::Value> val)
 {
-    CProfiler::Sample _("V8Helpers::V8ToRawBytes", true);
-    static WriteDelegate delegate;
+    static const uint32_t profilerId = CProfiler::RegisterName("V8Helpers::V8ToRawBytes");
+    CProfiler::Sample _(profilerId, true);
 
     v8::Isolate* isolate = v8::Isolate::GetCurrent();
     v8::Local<v8::Context> ctx = isolate->GetEnteredOrMicrotaskContext();
@@ -502,48 +725,66 @@ alt::MValueByteArray V8Helpers::V8ToRawBytes(v8::Local<v8::Value> val)
     RawValueType type = GetValueType(ctx, val);
     if(type == RawValueType::INVALID) return alt::MValueByteArray();
 
-    v8::ValueSerializer serializer(isolate, &delegate);
-    delegate.SetSerializer(&serializer);
+    RawBytesArena& arena = RawBytesArena::Get();
+    bool useArena = arena.Acquire();
 
-    serializer.WriteHeader();
+    alt::MValueByteArray bytes;
+    size_t size = 0;
+    {
+        WriteDelegate delegate(ctx, useArena ? &arena : nullptr);
+        v8::ValueSerializer serializer(isolate, &delegate);
+        delegate.SetSerializer(&serializer);
 
-    // Write the magic bytes to the buffer
-    serializer.WriteRawBytes(magicBytes, sizeof(magicBytes));
+        serializer.WriteHeader();
 
-    // Write the serialized value to the buffer
-    bool result;
-    if(!serializer.WriteValue(ctx, val).To(&result) || !result) return alt::MValueByteArray();
+        // Write the magic bytes to the buffer
+        serializer.WriteRawBytes(magicBytes, sizeof(magicBytes));
+
+        // Write the serialized value to the buffer
+        bool result;
+        if(serializer.WriteValue(ctx, val).To(&result) && result)
+        {
+            std::pair<uint8_t*, size_t> serialized = serializer.Release();
+            size = serialized.second;
+            bytes = alt::ICore::Instance().CreateMValueByteArray(serialized.first, serialized.second);
+            if(!useArena) free(serialized.first);
+        }
+    }
+    if(useArena) arena.Release(size);
+    if(!bytes) return bytes;
 
-    std::pair<uint8_t*, size_t> serialized = serializer.Release();
-    return alt::ICore::Instance().CreateMValueByteArray(serialized.first, serialized.second);
+    if(V8ResourceImpl* resource = V8ResourceImpl::Get(ctx)) resource->GetMetrics().AddRawSerializedBytes(size);
+    return bytes;
 }
 
 // Converts a MValue byte array to a JS value
 v8::MaybeLocal<v8::Value> V8Helpers::RawBytesToV8(alt::MValueByteArrayConst rawBytes)
 {
-    CProfiler::Sample _("V8Helpers::RawBytesToV8", true);
-    static ReadDelegate delegate;
+    static const uint32_t profilerId = CProfiler::RegisterName("V8Helpers::RawBytesToV8");
+    CProfiler::Sample _(profilerId, true);
 
+    // The deserializer reads directly from the data of the MValue
     const uint8_t* data = rawBytes->GetData();
     size_t size = rawBytes->GetSize();
-    if(size < sizeof(magicBytes)) return v8::MaybeLocal<v8::Value>();
+    if(!HasRawBytesHeader(data, size)) return v8::MaybeLocal<v8::Value>();
 
     v8::Isolate* isolate = v8::Isolate::GetCurrent();
     v8::Local<v8::Context> ctx = isolate->GetEnteredOrMicrotaskContext();
 
+    ReadDelegate delegate(ctx);
     v8::ValueDeserializer deserializer(isolate, data, size, &delegate);
     delegate.SetDeserializer(&deserializer);
 
     bool headerValid;
     if(!deserializer.ReadHeader(ctx).To(&headerValid) || !headerValid) return v8::MaybeLocal<v8::Value>();
 
-    // Check for magic bytes
-    uint8_t* magicBytesPtr;
-    if(!deserializer.ReadRawBytes(sizeof(magicBytes), (const void**)&magicBytesPtr)) return v8::MaybeLocal<v8::Value>();
-    if(memcmp(magicBytesPtr, magicBytes, sizeof(magicBytes)) != 0) return v8::MaybeLocal<v8::Value>();
+    // Skip the magic bytes, they were already checked
+    const void* magicBytesPtr;
+    if(!deserializer.ReadRawBytes(sizeof(magicBytes), &magicBytesPtr)) return v8::MaybeLocal<v8::Value>();
 
     // Deserialize the value
     v8::MaybeLocal<v8::Value> result = deserializer.ReadValue(ctx);
+    if(V8ResourceImpl* resource = V8ResourceImpl::Get(ctx); resource && !result.IsEmpty()) resource->GetMetrics().AddRawDeserializedBytes(size);
 
     return result;
 }
@@ -12,6 +12,10 @@ namespace V8Helpers
     alt::MValueByteArray V8ToRawBytes(v8::Local<v8::Value> val);
     v8::MaybeLocal<v8::Value> RawBytesToV8(alt::MValueByteArrayConst bytes);
 
+    // Large byte arrays reference the MValue data instead of copying it,
+    // scripts must not modify received buffers when this is enabled
+    void SetZeroCopyByteArrays(bool enabled);
+
     namespace Serialization
     {
         // A serialized JavaScript value
@@ -56,25 +60,37 @@ namespace V8Helpers
 
         // Serializes a JS value to a binary format
         // Make sure the context is entered before calling this function
-        inline Value Serialize(v8::Local<v8::Context> context, v8::Local<v8::Value> value, bool ownPtr = true)
+        // The array buffers in the transfer list are referenced by their index instead of being copied,
+        // the receiver has to pass array buffers with the same backing stores in the same order to Deserialize
+        inline Value Serialize(v8::Local<v8::Context> context, v8::Local<v8::Value> value, const std::vector<v8::Local<v8::ArrayBuffer>>& transfer, bool ownPtr = true)
         {
             v8::ValueSerializer serializer(context->GetIsolate());
             serializer.WriteHeader();
+            for(uint32_t i = 0; i < transfer.size(); i++) serializer.TransferArrayBuffer(i, transfer[i]);
             if(serializer.WriteValue(context, value).IsNothing()) return Value{};
             std::pair<uint8_t*, size_t> data = serializer.Release();
             return Value{ data.first, data.second, ownPtr };
         }
+        inline Value Serialize(v8::Local<v8::Context> context, v8::Local<v8::Value> value, bool ownPtr = true)
+        {
+            return Serialize(context, value, {}, ownPtr);
+        }
 
         // Deserializes a JS value from a binary format
         // Make sure the context is entered before calling this function
-        inline v8::MaybeLocal<v8::Value> Deserialize(v8::Local<v8::Context> context, const Value& value)
+        inline v8::MaybeLocal<v8::Value> Deserialize(v8::Local<v8::Context> context, const Value& value, const std::vector<v8::Local<v8::ArrayBuffer>>& transfer)
         {
             if(!value.Valid()) return v8::MaybeLocal<v8::Value>();
             v8::ValueDeserializer deserializer(context->GetIsolate(), value.data, value.size);
+            for(uint32_t i = 0; i < transfer.size(); i++) deserializer.TransferArrayBuffer(i, transfer[i]);
             v8::Maybe<bool> header = deserializer.ReadHeader(context);
             if(header.IsNothing() || header.FromJust() == false) return v8::MaybeLocal<v8::Value>();
             v8::MaybeLocal<v8::Value> result = deserializer.ReadValue(context);
             return result;
         }
+        inline v8::MaybeLocal<v8::Value> Deserialize(v8::Local<v8::Context> context, const Value& value)
+        {
+            return Deserialize(context, value, {});
+        }
     }  // namespace Serialization
 }  // namespace V8Helpers
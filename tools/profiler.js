@@ -1,46 +1,33 @@
 // clang-format off
-// This tool is used to convert the results of a JS module profiler .samples
-// file to a .json file.
+// This tool prints the aggregated stats of a JS module profiler .trace.json
+// file. The file itself can be opened directly in chrome://tracing or
+// https://ui.perfetto.dev.
 
 const fs = require("fs");
 
 // [0]     [1]           [2]           [3]
-// node profiler.js path/to/input path/to/output
+// node profiler.js path/to/input [path/to/output]
 const fileName = process.argv[2];
-let outName = process.argv[3];
-if (!outName) outName = fileName.replace(".samples", "") + ".json";
+const outName = process.argv[3];
 
-if (!fileName.endsWith(".samples") || !fs.existsSync(fileName)) {
+if (!fileName || !fileName.endsWith(".json") || !fs.existsSync(fileName)) {
     console.error("Invalid path specified");
     process.exit(1);
 }
 
-const file = fs.readFileSync(fileName, "utf8");
-
-const results = [];
-
-const lines = file.split("\n");
-for (const line of lines) {
-    if (line.length === 0) continue;
-    const [name, samplesStr] = line.split(" ");
-
-    const samples = samplesStr.split(",").map(x => parseInt(x)).sort((a, b) => a - b);
-
-    const sampleAmount = samples.length;
-    const min = samples[0];
-    const max = samples[sampleAmount - 1];
-
-    const avg = samples.reduce((a, b) => a + b, 0) / sampleAmount;
+const trace = JSON.parse(fs.readFileSync(fileName, "utf8"));
+if (!Array.isArray(trace.stats)) {
+    console.error("The specified file is not a JS module profiler trace");
+    process.exit(1);
+}
 
-    results.push({
-        name,
-        samples: sampleAmount,
-        min,
-        max,
-        avg
-    });
-    console.log(`${name} | Samples: ${sampleAmount} | Min: ${min} | Max: ${max} | Avg: ${avg}`);
+// All values are in microseconds
+const results = trace.stats.sort((a, b) => b.avg * b.count - a.avg * a.count);
+for (const { name, count, min, max, avg, p50, p99 } of results) {
+    console.log(`${name} | Samples: ${count} | Min: ${min} | Max: ${max} | Avg: ${avg} | P50: ${p50} | P99: ${p99}`);
 }
 
-fs.writeFileSync(outName, JSON.stringify(results, null, 4));
-console.log(`Wrote result to '${outName}'`);
+if (outName) {
+    fs.writeFileSync(outName, JSON.stringify(results, null, 4));
+    console.log(`Wrote result to '${outName}'`);
+}